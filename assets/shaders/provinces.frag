@@ -1,11 +1,12 @@
 uniform sampler2D texture;
-uniform sampler2D provincesTexture;
-uniform sampler2D baronyTexture;
-uniform sampler2D countyTexture;
-uniform sampler2D duchyTexture;
-uniform sampler2D kingdomTexture;
-uniform sampler2D empireTexture;
-uniform vec2 textureSize;
+uniform sampler2D provinceIdsTexture;
+uniform sampler2D bordersTexture;
+
+// The map is drawn in tiles (see TiledTexture), the textures above only
+// contain the pixels of the tile being drawn.
+uniform vec2 tilePosition;
+uniform vec2 tileSize;
+uniform vec2 mapSize;
 
 uniform float time;
 uniform int mapMode;
@@ -30,79 +31,68 @@ const int MAPMODE_DUCHY = 8;
 const int MAPMODE_KINGDOM = 9;
 const int MAPMODE_EMPIRE = 10;
 
-// The last (4th) element of the array is used to distinguish the type defined above.
-uniform vec4 selectedEntities[1000];
-uniform int selectedEntitiesCount;
-
-bool IsSelected(int type, vec4 color) {
-    bool selected = false;
-    vec3 rgb = color.rgb;
-    for(int i = 0; i < selectedEntitiesCount; i++) {
-        if(int(selectedEntities[i].a) != type)
-            continue;
-        if(rgb == selectedEntities[i].rgb)
-            return true;
-    }
-    return false;
+// Flags of each province (indexed by id+1) where the red channel
+// is set if the province is selected (see SelectionHandler::UpdateFlags).
+uniform sampler2D selectionTexture;
+uniform vec2 selectionTextureSize;
+
+// Color of the focused title of each tier for every province (indexed by id+1),
+// with one block of rows per tier (see Mod::GetTitlesColorsImage).
+uniform sampler2D titlesColorsTexture;
+uniform vec2 titlesColorsTextureSize;
+
+float GetProvinceIndex() {
+    // Id+1 of the province stored in the RGB bytes, 0 if there is none.
+    vec3 bytes = floor(texture2D(provinceIdsTexture, gl_TexCoord[0].xy).rgb * 255.0 + 0.5);
+    return bytes.r * 65536.0 + bytes.g * 256.0 + bytes.b;
 }
 
-bool IsBorder(sampler2D tex) {
-    // Calculate the texel size based on the texture dimensions
-    vec2 texelSize = 1.0 / textureSize;
-
-    // Sample the current pixel and its neighbors
-    vec4 currentColor = texture2D(tex, gl_TexCoord[0].xy);
-    vec4 leftColor = texture2D(tex, gl_TexCoord[0].xy + vec2(-texelSize.x, 0.0));
-    vec4 rightColor = texture2D(tex, gl_TexCoord[0].xy + vec2(texelSize.x, 0.0));
-    vec4 topColor = texture2D(tex, gl_TexCoord[0].xy + vec2(0.0, texelSize.y));
-    vec4 bottomColor = texture2D(tex, gl_TexCoord[0].xy + vec2(0.0, -texelSize.y));
-
-    // Check if the current pixel differs from any of its neighbors
-    return currentColor != leftColor
-        || currentColor != rightColor
-        || currentColor != topColor
-        || currentColor != bottomColor;
-    
-    // return currentColor != rightColor || currentColor != bottomColor;
+bool IsSelected(float index) {
+    if(index == 0.0)
+        return false;
+    vec2 texel = vec2(mod(index, selectionTextureSize.x), floor(index / selectionTextureSize.x));
+    return texture2D(selectionTexture, (texel + 0.5) / selectionTextureSize).r > 0.5;
 }
 
-vec4 GetEntityColor(int type) {
-    if(type == PROVINCE) return texture2D(provincesTexture, gl_TexCoord[0].xy);
-    if(type == BARONY) return texture2D(baronyTexture, gl_TexCoord[0].xy);
-    if(type == COUNTY) return texture2D(countyTexture, gl_TexCoord[0].xy);
-    if(type == DUCHY) return texture2D(duchyTexture, gl_TexCoord[0].xy);
-    if(type == KINGDOM) return texture2D(kingdomTexture, gl_TexCoord[0].xy);
-    if(type == EMPIRE) return texture2D(empireTexture, gl_TexCoord[0].xy);
-    return vec4(0.0, 0.0, 0.0, 1.0);
+vec4 GetTitleColor(float index, int tier) {
+    float rowsCount = titlesColorsTextureSize.y / 5.0;
+    vec2 texel = vec2(mod(index, titlesColorsTextureSize.x), float(tier) * rowsCount + floor(index / titlesColorsTextureSize.x));
+    return texture2D(titlesColorsTexture, (texel + 0.5) / titlesColorsTextureSize);
 }
 
 int GetBorderTier() {
-    // Check if it is the border of a province first to avoid unless calculation for highter tier.
-    if(!IsBorder(provincesTexture)) return -1;
-    if(mapMode >= MAPMODE_EMPIRE && IsBorder(empireTexture)) return 5;
-    if(mapMode >= MAPMODE_KINGDOM && IsBorder(kingdomTexture)) return 4;
-    if(mapMode >= MAPMODE_DUCHY && IsBorder(duchyTexture)) return 3;
-    if(mapMode >= MAPMODE_COUNTY && IsBorder(countyTexture)) return 2;
-    if(mapMode >= MAPMODE_BARONY && IsBorder(baronyTexture)) return 1;
-    return 0;
+    // The border mask is computed on the CPU (see Mod::UpdateBorderMask) with one byte
+    // per pixel holding the highest tier+1 at which the pixel is on a border (0 if none),
+    // and 4 pixels are packed in each texel of the texture.
+    float x = floor(gl_TexCoord[0].x * tileSize.x);
+    float packedWidth = ceil(tileSize.x / 4.0);
+    vec4 texel = texture2D(bordersTexture, vec2((floor(x / 4.0) + 0.5) / packedWidth, gl_TexCoord[0].y));
+    float value = dot(texel, vec4(equal(vec4(mod(x, 4.0)), vec4(0.0, 1.0, 2.0, 3.0))));
+    float tier = floor(value * 255.0 + 0.5) - 1.0;
+
+    // Only display the borders up to the tier of the map mode.
+    if(tier <= 0.0) return int(tier);
+    return int(min(tier, max(0.0, float(mapMode - MAPMODE_BARONY + 1))));
 }
 
 void main() {
     vec2 pixelPos = gl_TexCoord[0].xy;
+    vec2 mapPos = (tilePosition + pixelPos * tileSize) / mapSize;
     vec4 pixelColor = texture2D(texture, pixelPos);
-    vec4 provincePixelColor = texture2D(provincesTexture, pixelPos);
+    float provinceIndex = GetProvinceIndex();
+
+    // Title map modes are drawn with the provinces texture,
+    // replace the color of provinces by their title's.
+    if(mapMode >= MAPMODE_BARONY && provinceIndex > 0.0)
+        pixelColor = GetTitleColor(provinceIndex, mapMode - MAPMODE_BARONY);
 
     // Final color that will be used for the pixel.
     vec4 color = gl_Color * pixelColor;
     float alpha = color.a;
 
-    for(int i = EMPIRE; i >= PROVINCE; i--) {
-        bool isSelected = IsSelected(i, GetEntityColor(i));
-        if(isSelected) {
-            float v = abs(sin(2.0*time)+3.0)/6.0;
-            color = vec4(v, v, v, 1.0);
-            break;
-        }
+    if(IsSelected(provinceIndex)) {
+        float v = abs(sin(2.0*time)+3.0)/6.0;
+        color = vec4(v, v, v, 1.0);
     }
 
     if(displayBorders) {
@@ -123,7 +113,7 @@ void main() {
 
     if((mapMode == MAPMODE_CULTURE || mapMode == MAPMODE_RELIGION) && alpha == 0.0) {
         color.a = 1.0;
-        if(cos(10000.0*(pixelPos.x+pixelPos.y)) >= 0.5) {
+        if(cos(10000.0*(mapPos.x+mapPos.y)) >= 0.5) {
             color = mix(color, vec4(0.0, 0.0, 0.0, 1.0), 0.75);
         }
     }
@@ -62,6 +62,8 @@ void App::Init() {
 #ifdef DEBUG
     LOG_INFO("DEBUG_MODE is enabled", "");
     Parser::Tests();
+    Image::Tests();
+    Mod::Tests();
     this->DebugSettings();
 #elif _WIN32
     ShowWindow(GetConsoleWindow(), SW_HIDE);
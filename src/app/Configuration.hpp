@@ -29,6 +29,13 @@ public:
     inline static std::string githubURL = "https://github.com/Xorrad/meckt";
 
     inline static sf::Vector2u windowResolution = {800, 600};
+
+    // Whether the left and right edges of the map touch each other.
+    inline static bool mapWrapHorizontally = false;
+
+    // Maximum size in bytes of the map modes textures kept in memory, the
+    // least recently shown ones are released above it (see EditorMenu::EvictTextures).
+    inline static uint64_t mapTexturesMemoryBudget = 512ull * 1024 * 1024;
     
     // Resources
     inline static ResourceManager<sf::Texture, Textures> textures = ResourceManager<sf::Texture, Textures>("texture");
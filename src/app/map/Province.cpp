@@ -58,16 +58,160 @@ ProvinceFlags& operator&=(ProvinceFlags& a, ProvinceFlags b) {
     return a = a & b;
 }
 
+const Bitset& ProvincesIndex::GetProvinces() const {
+    return m_Provinces;
+}
+
+const Bitset& ProvincesIndex::GetFlag(ProvinceFlags flag) const {
+    const uint bit = std::countr_zero((uint) flag);
+    if(flag == ProvinceFlags::NONE || bit >= FLAGS_COUNT) {
+        static const Bitset none;
+        return none;
+    }
+    return m_Flags[bit];
+}
+
+const Bitset& ProvincesIndex::GetAttribute(ProvinceAttribute attribute, uint id) const {
+    const std::vector<Bitset>& ids = m_Attributes[(int) attribute];
+    if(id >= ids.size()) {
+        static const Bitset none;
+        return none;
+    }
+    return ids[id];
+}
+
+const std::vector<sf::Uint32>& ProvincesIndex::GetColorsColumn() const {
+    return m_ColorsColumn;
+}
+
+const std::vector<ProvinceFlags>& ProvincesIndex::GetFlagsColumn() const {
+    return m_FlagsColumn;
+}
+
+const std::vector<uint>& ProvincesIndex::GetAttributeColumn(ProvinceAttribute attribute) const {
+    return m_AttributesColumns[(int) attribute];
+}
+
+const std::vector<uint>& ProvincesIndex::GetPixelsCountColumn() const {
+    return m_PixelsCountColumn;
+}
+
+std::vector<uint> ProvincesIndex::GetProvincesCountByAttribute(ProvinceAttribute attribute) const {
+    std::vector<uint> counts(m_Attributes[(int) attribute].size(), 0);
+    for(uint id = 0; id < counts.size(); id++)
+        counts[id] = m_Attributes[(int) attribute][id].count();
+    return counts;
+}
+
+std::vector<uint> ProvincesIndex::GetPixelsCountByAttribute(ProvinceAttribute attribute) const {
+    const std::vector<uint>& ids = m_AttributesColumns[(int) attribute];
+    std::vector<uint> counts(m_Attributes[(int) attribute].size(), 0);
+    for(uint i = 0; i < ids.size(); i++)
+        counts[ids[i]] += m_PixelsCountColumn[i];
+    return counts;
+}
+
+void ProvincesIndex::Add(Province& province) {
+    if(province.m_Index != nullptr)
+        province.m_Index->Remove(province);
+
+    const int id = province.GetId();
+    if((uint) id >= m_ColorsColumn.size()) {
+        m_ColorsColumn.resize(id + 1, 0);
+        m_FlagsColumn.resize(id + 1, ProvinceFlags::NONE);
+        for(std::vector<uint>& column : m_AttributesColumns)
+            column.resize(id + 1, 0);
+        m_PixelsCountColumn.resize(id + 1, 0);
+    }
+    m_ColorsColumn[id] = province.GetColorId();
+    m_PixelsCountColumn[id] = province.GetImagePixelsCount();
+    m_ModifiedProvinces.set(id);
+
+    m_Provinces.set(id);
+    this->UpdateFlags(id, ProvinceFlags::NONE, province.GetFlags());
+    for(int attribute = 0; attribute < (int) ProvinceAttribute::COUNT; attribute++) {
+        std::vector<Bitset>& ids = m_Attributes[attribute];
+        const uint value = province.GetAttributeId((ProvinceAttribute) attribute);
+        if(value >= ids.size())
+            ids.resize(value + 1);
+        ids[value].set(id);
+        m_AttributesColumns[attribute][id] = value;
+    }
+    province.m_Index = this;
+}
+
+void ProvincesIndex::Remove(Province& province) {
+    if(province.m_Index != this)
+        return;
+
+    const int id = province.GetId();
+    m_ColorsColumn[id] = 0;
+    m_PixelsCountColumn[id] = 0;
+    m_ModifiedProvinces.set(id);
+
+    m_Provinces.set(id, false);
+    this->UpdateFlags(id, province.GetFlags(), ProvinceFlags::NONE);
+    for(int attribute = 0; attribute < (int) ProvinceAttribute::COUNT; attribute++) {
+        std::vector<Bitset>& ids = m_Attributes[attribute];
+        const uint value = province.GetAttributeId((ProvinceAttribute) attribute);
+        if(value < ids.size())
+            ids[value].set(id, false);
+        m_AttributesColumns[attribute][id] = 0;
+    }
+    province.m_Index = nullptr;
+}
+
+void ProvincesIndex::UpdateFlags(int provinceId, ProvinceFlags previousFlags, ProvinceFlags flags) {
+    const uint changedFlags = (uint) previousFlags ^ (uint) flags;
+    for(uint bit = 0; bit < FLAGS_COUNT; bit++) {
+        if(changedFlags & (1 << bit))
+            m_Flags[bit].set(provinceId, (uint) flags & (1 << bit));
+    }
+    m_FlagsColumn[provinceId] = flags;
+}
+
+void ProvincesIndex::UpdateAttribute(ProvinceAttribute attribute, int provinceId, uint previousId, uint id) {
+    std::vector<Bitset>& ids = m_Attributes[(int) attribute];
+    if(previousId < ids.size())
+        ids[previousId].set(provinceId, false);
+    if(id >= ids.size())
+        ids.resize(id + 1);
+    ids[id].set(provinceId);
+    m_AttributesColumns[(int) attribute][provinceId] = id;
+    m_ModifiedProvinces.set(provinceId);
+}
+
+void ProvincesIndex::UpdateColor(int provinceId, sf::Color color) {
+    m_ColorsColumn[provinceId] = color.toInteger();
+}
+
+void ProvincesIndex::UpdatePixelsCount(int provinceId, uint count) {
+    m_PixelsCountColumn[provinceId] = count;
+}
+
+Bitset ProvincesIndex::TakeModifiedProvinces() {
+    Bitset modifiedProvinces;
+    std::swap(modifiedProvinces, m_ModifiedProvinces);
+    return modifiedProvinces;
+}
+
 Province::Province(int id, sf::Color color, std::string name) {
     m_Id = id;
     m_Color = color;
     m_Name = name;
     m_Flags = ProvinceFlags::NONE;
-    m_Holding = "none";
-    m_Terrain = "";
-    m_OriginalData = MakeShared<Parser::Object>();
+    m_Holding = 0;
+    m_Terrain = 0;
+    m_Culture = 0;
+    m_Religion = 0;
+    m_Index = nullptr;
+    m_OriginalFilePath = 0;
+    m_OriginalHash = 0;
+    m_OriginalData = nullptr;
     m_ImagePosition = sf::Vector2i(0, 0);
     m_ImagePixelsCount = 0;
+    m_ImageBoundingBox = sf::IntRect(0, 0, 0, 0);
+    m_ImageCentroid = sf::Vector2f(0, 0);
 }
 
 int Province::GetId() const {
@@ -94,69 +238,106 @@ bool Province::HasFlag(ProvinceFlags flag) const {
     return (bool) (m_Flags & flag);
 }
 
-std::string Province::GetHolding() const {
+uint Province::GetHoldingId() const {
     return m_Holding;
 }
 
-std::string Province::GetTerrain() const {
+uint Province::GetTerrainId() const {
     return m_Terrain;
 }
 
-std::string Province::GetCulture() const {
+uint Province::GetCultureId() const {
     return m_Culture;
 }
 
-std::string Province::GetReligion() const {
+uint Province::GetReligionId() const {
     return m_Religion;
 }
 
+uint Province::GetAttributeId(ProvinceAttribute attribute) const {
+    switch(attribute) {
+        case ProvinceAttribute::HOLDING: return m_Holding;
+        case ProvinceAttribute::TERRAIN: return m_Terrain;
+        case ProvinceAttribute::CULTURE: return m_Culture;
+        case ProvinceAttribute::RELIGION: return m_Religion;
+        default: return 0;
+    }
+}
+
 void Province::SetName(std::string name) {
     m_Name = name;
 }
 
 void Province::SetColor(sf::Color color) {
+    if(m_Index != nullptr)
+        m_Index->UpdateColor(m_Id, color);
     m_Color = color;
 }
 
 void Province::SetFlags(ProvinceFlags flags) {
+    if(m_Index != nullptr)
+        m_Index->UpdateFlags(m_Id, m_Flags, flags);
     m_Flags = flags;
 }
 
 void Province::SetFlag(ProvinceFlags flag, bool enabled) {
-    if(enabled) m_Flags |= flag;
-    else m_Flags &= (~flag);
+    this->SetFlags(enabled ? (m_Flags | flag) : (m_Flags & ~flag));
 }
 
-void Province::SetHolding(std::string holding) {
+void Province::SetHoldingId(uint holding) {
+    if(m_Index != nullptr)
+        m_Index->UpdateAttribute(ProvinceAttribute::HOLDING, m_Id, m_Holding, holding);
     m_Holding = holding;
 }
 
-void Province::SetTerrain(std::string terrain) {
+void Province::SetTerrainId(uint terrain) {
+    if(m_Index != nullptr)
+        m_Index->UpdateAttribute(ProvinceAttribute::TERRAIN, m_Id, m_Terrain, terrain);
     m_Terrain = terrain;
 }
 
-void Province::SetCulture(std::string culture) {
+void Province::SetCultureId(uint culture) {
+    if(m_Index != nullptr)
+        m_Index->UpdateAttribute(ProvinceAttribute::CULTURE, m_Id, m_Culture, culture);
     m_Culture = culture;
 }
 
-void Province::SetReligion(std::string religion) {
+void Province::SetReligionId(uint religion) {
+    if(m_Index != nullptr)
+        m_Index->UpdateAttribute(ProvinceAttribute::RELIGION, m_Id, m_Religion, religion);
     m_Religion = religion;
 }
 
-std::string Province::GetOriginalFilePath() const {
+uint Province::GetOriginalFilePathId() const {
     return m_OriginalFilePath;
 }
 
+File::Span Province::GetOriginalSpan() const {
+    return m_OriginalSpan;
+}
+
+uint64_t Province::GetOriginalHash() const {
+    return m_OriginalHash;
+}
+
 SharedPtr<Parser::Object> Province::GetOriginalData() const {
     return m_OriginalData;
 }
 
-void Province::SetOriginalFilePath(const std::string& filePath) {
+void Province::SetOriginalFilePathId(uint filePath) {
     m_OriginalFilePath = filePath;
 }
 
-void Province::SetOriginalData(SharedPtr<Parser::Object> data) {
-    m_OriginalData = data;
+void Province::SetOriginalSpan(File::Span span, uint64_t hash) {
+    m_OriginalSpan = span;
+    m_OriginalHash = hash;
+    m_OriginalData = nullptr;
+}
+
+void Province::SetOriginalData(SharedPtr<Parser::Object> data, uint64_t hash) {
+    m_OriginalSpan = (data == nullptr) ? File::Span() : data->GetSpan();
+    m_OriginalHash = hash;
+    m_OriginalData = m_OriginalSpan.IsEmpty() ? data : nullptr;
 }
 
 sf::Vector2i Province::GetImagePosition() const {
@@ -167,14 +348,28 @@ uint Province::GetImagePixelsCount() const {
     return m_ImagePixelsCount;
 }
 
+sf::IntRect Province::GetImageBoundingBox() const {
+    return m_ImageBoundingBox;
+}
+
+sf::Vector2f Province::GetImageCentroid() const {
+    return m_ImageCentroid;
+}
+
 void Province::SetImagePosition(sf::Vector2i pos) {
     m_ImagePosition = pos;
 }
 
 void Province::SetImagePixelsCount(uint count) {
+    if(m_Index != nullptr)
+        m_Index->UpdatePixelsCount(m_Id, count);
     m_ImagePixelsCount = count;
 }
 
-void Province::IncrementImagePixelsCount() {
-    m_ImagePixelsCount++;
+void Province::SetImageBoundingBox(sf::IntRect box) {
+    m_ImageBoundingBox = box;
+}
+
+void Province::SetImageCentroid(sf::Vector2f centroid) {
+    m_ImageCentroid = centroid;
 }
\ No newline at end of file
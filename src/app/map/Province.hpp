@@ -45,8 +45,76 @@ ProvinceFlags operator~(ProvinceFlags a);
 ProvinceFlags& operator|=(ProvinceFlags& a, ProvinceFlags b);
 ProvinceFlags& operator&=(ProvinceFlags& a, ProvinceFlags b);
 
+// Horizontal run of pixels [x0, x1) of a province in a row of the provinces image.
+struct ProvinceSpan {
+    uint row;
+    uint x0;
+    uint x1;
+};
+
+enum class ProvinceAttribute {
+    HOLDING,
+    TERRAIN,
+    CULTURE,
+    RELIGION,
+    COUNT,
+};
+
+class Province;
+
+// Ids of the provinces having each flag and each holding, terrain, culture and
+// religion (by id, see Province::GetCultureId), kept up to date by the setters
+// of the provinces added to the index, to select provinces with bitwise operations.
+// The index also stores the attributes of the provinces in columns indexed by
+// province id, to loop over all of them without going through the Province objects
+// (the entries of the ids without province are zero).
+class ProvincesIndex {
+public:
+    const Bitset& GetProvinces() const;
+    const Bitset& GetFlag(ProvinceFlags flag) const;
+    const Bitset& GetAttribute(ProvinceAttribute attribute, uint id) const;
+
+    const std::vector<sf::Uint32>& GetColorsColumn() const;
+    const std::vector<ProvinceFlags>& GetFlagsColumn() const;
+    const std::vector<uint>& GetAttributeColumn(ProvinceAttribute attribute) const;
+    const std::vector<uint>& GetPixelsCountColumn() const;
+
+    // Number of provinces and of pixels of the provinces for each id of an attribute.
+    std::vector<uint> GetProvincesCountByAttribute(ProvinceAttribute attribute) const;
+    std::vector<uint> GetPixelsCountByAttribute(ProvinceAttribute attribute) const;
+
+    // Index the current flags and attributes of a province and attach
+    // the index to it, until it is removed (when the mod is destroyed).
+    void Add(Province& province);
+    void Remove(Province& province);
+
+    void UpdateFlags(int provinceId, ProvinceFlags previousFlags, ProvinceFlags flags);
+    void UpdateAttribute(ProvinceAttribute attribute, int provinceId, uint previousId, uint id);
+    void UpdateColor(int provinceId, sf::Color color);
+    void UpdatePixelsCount(int provinceId, uint count);
+
+    // Ids of the provinces added, removed or whose attributes changed
+    // since the last call, to update the data computed from them.
+    Bitset TakeModifiedProvinces();
+
+private:
+    static constexpr uint FLAGS_COUNT = 7;
+
+    Bitset m_Provinces;
+    std::array<Bitset, FLAGS_COUNT> m_Flags;
+    std::array<std::vector<Bitset>, (int) ProvinceAttribute::COUNT> m_Attributes;
+
+    std::vector<sf::Uint32> m_ColorsColumn;
+    std::vector<ProvinceFlags> m_FlagsColumn;
+    std::array<std::vector<uint>, (int) ProvinceAttribute::COUNT> m_AttributesColumns;
+    std::vector<uint> m_PixelsCountColumn;
+
+    Bitset m_ModifiedProvinces;
+};
+
 class Province {
 friend PropertiesTab;
+friend ProvincesIndex;
 public:
     Province(int id, sf::Color color, std::string name);
 
@@ -56,30 +124,37 @@ public:
     std::string GetName() const;
     ProvinceFlags GetFlags() const;
     bool HasFlag(ProvinceFlags flag) const;
-    std::string GetHolding() const;
-    std::string GetTerrain() const;
-    std::string GetCulture() const;
-    std::string GetReligion() const;
+    uint GetHoldingId() const;
+    uint GetTerrainId() const;
+    uint GetCultureId() const;
+    uint GetReligionId() const;
+    uint GetAttributeId(ProvinceAttribute attribute) const;
 
     void SetName(std::string name);
     void SetColor(sf::Color color);
     void SetFlags(ProvinceFlags flags);
     void SetFlag(ProvinceFlags flag, bool enabled);
-    void SetHolding(std::string holding);
-    void SetTerrain(std::string terrain);
-    void SetCulture(std::string culture);
-    void SetReligion(std::string religion);
+    void SetHoldingId(uint holding);
+    void SetTerrainId(uint terrain);
+    void SetCultureId(uint culture);
+    void SetReligionId(uint religion);
     
-    std::string GetOriginalFilePath() const;
+    uint GetOriginalFilePathId() const;
+    File::Span GetOriginalSpan() const;
+    uint64_t GetOriginalHash() const;
     SharedPtr<Parser::Object> GetOriginalData() const;
-    void SetOriginalFilePath(const std::string& filePath);
-    void SetOriginalData(SharedPtr<Parser::Object> data);
+    void SetOriginalFilePathId(uint filePath);
+    void SetOriginalSpan(File::Span span, uint64_t hash);
+    void SetOriginalData(SharedPtr<Parser::Object> data, uint64_t hash);
     
     sf::Vector2i GetImagePosition() const;
     uint GetImagePixelsCount() const;
+    sf::IntRect GetImageBoundingBox() const;
+    sf::Vector2f GetImageCentroid() const;
     void SetImagePosition(sf::Vector2i pos);
     void SetImagePixelsCount(uint count);
-    void IncrementImagePixelsCount();
+    void SetImageBoundingBox(sf::IntRect box);
+    void SetImageCentroid(sf::Vector2f centroid);
 
 private:
     int m_Id;
@@ -87,17 +162,32 @@ private:
     sf::Color m_Color;
     ProvinceFlags m_Flags;
 
-    std::string m_Holding;
-    std::string m_Terrain;
-    
-    std::string m_Culture;
-    std::string m_Religion;
-
-    std::string m_OriginalFilePath;
+    // Ids of the names of the holding, terrain, culture and religion in the
+    // pools of the mod (see Mod::GetHoldingNames), 0 if they are not set.
+    uint m_Holding;
+    uint m_Terrain;
+    uint m_Culture;
+    uint m_Religion;
+
+    // Index of the mod updated when the flags or attributes change, if any.
+    ProvincesIndex* m_Index;
+
+    // Block of the history of the province in its original file, read back
+    // when exporting. The parsed data is only kept if there is no such block
+    // (e.g. histories merged from several blocks), nullptr otherwise. The hash
+    // of the block checks that the file wasn't modified outside of the editor.
+    // The file path is an id in the file paths of the mod (see Mod::GetFilePaths).
+    uint m_OriginalFilePath;
+    File::Span m_OriginalSpan;
+    uint64_t m_OriginalHash;
     SharedPtr<Parser::Object> m_OriginalData;
 
+    // Geometry of the province in the provinces image, where the position
+    // is an interior point (the farthest pixel from the province borders).
     sf::Vector2i m_ImagePosition;
     uint m_ImagePixelsCount;
+    sf::IntRect m_ImageBoundingBox;
+    sf::Vector2f m_ImageCentroid;
 
     // Sea-zone for port
     // Terrain
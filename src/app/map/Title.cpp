@@ -9,12 +9,21 @@ Title::Title(std::string name, sf::Color color, bool landless) :
     m_Name(name),
     m_Color(color),
     m_Landless(landless),
-    m_OriginalData(MakeShared<Parser::Object>()),
+    m_Id(-1),
+    m_Hierarchy(nullptr),
+    m_OriginalFilePath(0),
+    m_OriginalHistoryFilePath(0),
+    m_OriginalHash(0),
+    m_OriginalData(nullptr),
     m_SelectionFocus(true)
 {}
 
 // Title::Title(const Title& title) : Title(title.GetName(), title.GetColor()) {}
 
+int Title::GetId() const {
+    return m_Id;
+}
+
 std::string Title::GetName() const {
     return m_Name;
 }
@@ -36,6 +45,11 @@ bool Title::Is(TitleType type) const {
 }
 
 bool Title::IsVassal(SharedPtr<HighTitle> title) const {
+    if(title == nullptr)
+        return false;
+    if(m_Hierarchy != nullptr && m_Hierarchy == title->m_Hierarchy)
+        return (int) title->GetType() > (int) this->GetType() && m_Hierarchy->GetAncestorId(m_Id, title->GetType()) == title->m_Id;
+
     SharedPtr<HighTitle> liege = this->m_LiegeTitle;
     while(liege != nullptr) {
         if(liege == title)
@@ -55,112 +69,124 @@ void Title::SetColor(sf::Color color) {
 
 void Title::SetLiegeTitle(SharedPtr<HighTitle> title) {
     m_LiegeTitle = title;
+    if(m_Hierarchy != nullptr)
+        m_Hierarchy->Update(*this);
 }
 
 void Title::SetLandless(bool landless) {
     m_Landless = landless;
 }
 
-std::string Title::GetOriginalFilePath() const {
+uint Title::GetOriginalFilePathId() const {
     return m_OriginalFilePath;
 }
 
+File::Span Title::GetOriginalSpan() const {
+    return m_OriginalSpan;
+}
+
+uint64_t Title::GetOriginalHash() const {
+    return m_OriginalHash;
+}
+
 SharedPtr<Parser::Object> Title::GetOriginalData() const {
     return m_OriginalData;
 }
 
-void Title::SetOriginalFilePath(const std::string& filePath) {
+void Title::SetOriginalFilePathId(uint filePath) {
     m_OriginalFilePath = filePath;
 }
 
-void Title::SetOriginalData(SharedPtr<Parser::Object> data) {
-    m_OriginalData = data;
+void Title::SetOriginalSpan(File::Span span, uint64_t hash) {
+    m_OriginalSpan = span;
+    m_OriginalHash = hash;
+    m_OriginalData = nullptr;
 }
 
-std::string Title::GetOriginalHistoryFilePath() const {
+void Title::SetOriginalData(SharedPtr<Parser::Object> data, uint64_t hash) {
+    m_OriginalSpan = (data == nullptr) ? File::Span() : data->GetSpan();
+    m_OriginalHash = hash;
+    m_OriginalData = m_OriginalSpan.IsEmpty() ? data : nullptr;
+}
+
+uint Title::GetOriginalHistoryFilePathId() const {
     return m_OriginalHistoryFilePath;
 }
 
-void Title::SetOriginalHistoryFilePath(const std::string& filePath) {
+void Title::SetOriginalHistoryFilePathId(uint filePath) {
     m_OriginalHistoryFilePath = filePath;
 }
 
-std::map<Date, SharedPtr<Parser::Object>>& Title::GetHistory() {
+FlatMap<Date, SharedPtr<Parser::Object>>& Title::GetHistory() {
     return m_History;
 }
 
 void Title::AddHistory(Date date, SharedPtr<Parser::Object> data) {
+    if(m_Hierarchy != nullptr) {
+        TitleReferences& references = m_Hierarchy->GetReferences();
+        if(m_History.count(date) > 0)
+            references.RemoveHistory(*this, date, m_History.at(date));
+        references.AddHistory(*this, date, data);
+    }
     m_History[date] = data;
 }
 
 void Title::RemoveHistory(Date date) {
+    if(m_Hierarchy != nullptr && m_History.count(date) > 0)
+        m_Hierarchy->GetReferences().RemoveHistory(*this, date, m_History.at(date));
     m_History.erase(date);
 }
 
-std::map<std::string, std::string>& Title::GetCulturalNames() {
+FlatMap<std::string, std::string>& Title::GetCulturalNames() {
     return m_CulturalNames;
 }
 
 void Title::AddCulturalName(const std::string& culture, std::string name) {
+    if(m_Hierarchy != nullptr)
+        m_Hierarchy->GetReferences().Add(culture, { ReferenceType::CULTURAL_NAME, this });
     m_CulturalNames[culture] = name;
 }
 
 void Title::RemoveCulturalName(const std::string& culture) {
+    if(m_Hierarchy != nullptr)
+        m_Hierarchy->GetReferences().Remove(culture, { ReferenceType::CULTURAL_NAME, this });
     m_CulturalNames.erase(culture);
 }
 
-std::map<std::string, std::string>& Title::GetLocNames() {
-    return m_LocNames;
+std::string Title::GetLocName(const StringPool& strings, const std::string& lang) const {
+    return this->GetLocalization(strings, lang, &Localization::name);
 }
 
-std::string& Title::GetLocName(const std::string& lang) {
-    return m_LocNames[lang];
+void Title::SetLocName(StringPool& strings, const std::string& lang, const std::string& name) {
+    this->SetLocalization(strings, lang, &Localization::name, name);
 }
 
-std::string Title::GetLocName(const std::string& lang) const {
-    if(m_LocNames.count(lang) == 0)
-        return "";
-    return m_LocNames.at(lang);
+std::string Title::GetLocAdjective(const StringPool& strings, const std::string& lang) const {
+    return this->GetLocalization(strings, lang, &Localization::adjective);
 }
 
-void Title::SetLocName(const std::string& lang, std::string name) {
-    m_LocNames[lang] = name;
+void Title::SetLocAdjective(StringPool& strings, const std::string& lang, const std::string& adjective) {
+    this->SetLocalization(strings, lang, &Localization::adjective, adjective);
 }
 
-std::map<std::string, std::string>& Title::GetLocAdjectives() {
-    return m_LocAdjectives;
+std::string Title::GetLocArticle(const StringPool& strings, const std::string& lang) const {
+    return this->GetLocalization(strings, lang, &Localization::article);
 }
 
-std::string& Title::GetLocAdjective(const std::string& lang) {
-    return m_LocAdjectives[lang];
+void Title::SetLocArticle(StringPool& strings, const std::string& lang, const std::string& article) {
+    this->SetLocalization(strings, lang, &Localization::article, article);
 }
 
-std::string Title::GetLocAdjective(const std::string& lang) const {
-    if(m_LocAdjectives.count(lang) == 0)
+std::string Title::GetLocalization(const StringPool& strings, const std::string& lang, uint Localization::* field) const {
+    const int langId = strings.Find(lang);
+    if(langId < 0)
         return "";
-    return m_LocAdjectives.at(lang);
-}
-
-void Title::SetLocAdjective(const std::string& lang, std::string adjective) {
-    m_LocAdjectives[lang] = adjective;
-}
-
-std::map<std::string, std::string>& Title::GetLocArticles() {
-    return m_LocArticles;
+    const auto& it = m_Localization.find(langId);
+    return (it == m_Localization.end()) ? "" : strings.Get(it->second.*field);
 }
 
-std::string& Title::GetLocArticle(const std::string& lang) {
-    return m_LocArticles[lang];
-}
-
-std::string Title::GetLocArticle(const std::string& lang) const {
-    if(m_LocArticles.count(lang) == 0)
-        return "";
-    return m_LocArticles.at(lang);
-}
-
-void Title::SetLocArticle(const std::string& lang, std::string article) {
-    m_LocArticles[lang] = article;
+void Title::SetLocalization(StringPool& strings, const std::string& lang, uint Localization::* field, const std::string& value) {
+    m_Localization[strings.Intern(lang)].*field = strings.Intern(value);
 }
 
 bool Title::HasSelectionFocus() const {
@@ -184,31 +210,43 @@ SharedPtr<CountyTitle>& HighTitle::GetCapitalTitle() {
 }
 
 bool HighTitle::IsDejureTitle(const SharedPtr<Title>& title) {
-    return std::find(m_DejureTitles.begin(), m_DejureTitles.end(), title) != m_DejureTitles.end();
+    // The liege of a title is always the title holding it in its dejure titles.
+    return title != nullptr && title->GetLiegeTitle().get() == this;
 }
 
 void HighTitle::AddDejureTitle(SharedPtr<Title> title) {
-    if(title == nullptr)
+    if(title == nullptr || this->IsDejureTitle(title))
         return;
 
-    if(!this->IsDejureTitle(title))
-        m_DejureTitles.push_back(title);
-
     SharedPtr<HighTitle> previousLiege = title->GetLiegeTitle();
     if(previousLiege != nullptr) {
         previousLiege->RemoveDejureTitle(title);
     }
+    m_DejureTitles.push_back(title);
     title->SetLiegeTitle(shared_from_this());
 }
 
 void HighTitle::RemoveDejureTitle(SharedPtr<Title> title) {
-    if(title == nullptr)
+    // A title that isn't a vassal of this one keeps its actual liege.
+    if(!this->IsDejureTitle(title))
         return;
-    m_DejureTitles.erase(std::remove(m_DejureTitles.begin(), m_DejureTitles.end(), title), m_DejureTitles.end());
+
+    // The vassals keep their order (displayed and exported), so only
+    // the ones after the title are shifted.
+    const auto& it = std::find(m_DejureTitles.begin(), m_DejureTitles.end(), title);
+    if(it != m_DejureTitles.end())
+        m_DejureTitles.erase(it);
     title->SetLiegeTitle(nullptr);
 }
 
 void HighTitle::SetCapitalTitle(SharedPtr<CountyTitle> title) {
+    if(m_Hierarchy != nullptr) {
+        TitleReferences& references = m_Hierarchy->GetReferences();
+        if(m_CapitalTitle != nullptr)
+            references.Remove(m_CapitalTitle->GetName(), { ReferenceType::CAPITAL, this });
+        if(title != nullptr)
+            references.Add(title->GetName(), { ReferenceType::CAPITAL, this });
+    }
     m_CapitalTitle = title;
 }
 
@@ -221,9 +259,44 @@ void HighTitle::SetSelectionFocus(bool focus) {
 }
 
 sf::Vector2i HighTitle::GetImagePosition(SharedPtr<Mod> mod) const {
-    if(m_DejureTitles.empty())
+    // Use the position of the province closest to the centroid of
+    // all the dejure provinces (weighted by their area), so that the
+    // position is always on the land of the title.
+    std::vector<SharedPtr<Province>> provinces;
+    std::function<void(const std::vector<SharedPtr<Title>>&)> AddProvinces = [&](const auto& titles) {
+        for(const auto& title : titles) {
+            if(title->Is(TitleType::BARONY)) {
+                const SharedPtr<Province>& province = mod->GetProvinceById(StaticCastSharedPtr<BaronyTitle>(title)->GetProvinceId());
+                if(province != nullptr && province->GetImagePixelsCount() > 0)
+                    provinces.push_back(province);
+            }
+            else {
+                AddProvinces(StaticCastSharedPtr<HighTitle>(title)->GetDejureTitles());
+            }
+        }
+    };
+    AddProvinces(m_DejureTitles);
+
+    if(provinces.empty())
         return sf::Vector2i(0, 0);
-    return m_DejureTitles.front()->GetImagePosition(mod);
+
+    sf::Vector2f centroid = sf::Vector2f(0, 0);
+    float totalPixels = 0;
+
+    for(const auto& province : provinces) {
+        centroid += province->GetImageCentroid() * (float) province->GetImagePixelsCount();
+        totalPixels += province->GetImagePixelsCount();
+    }
+    centroid /= totalPixels;
+
+    const auto& DistanceToCentroid = [&](const SharedPtr<Province>& province) {
+        sf::Vector2f d = sf::Vector2f(province->GetImagePosition()) - centroid;
+        return d.x * d.x + d.y * d.y;
+    };
+
+    return (*std::min_element(provinces.begin(), provinces.end(), [&](const auto& a, const auto& b) {
+        return DistanceToCentroid(a) < DistanceToCentroid(b);
+    }))->GetImagePosition();
 }
 
 BaronyTitle::BaronyTitle() : Title() {}
@@ -240,6 +313,8 @@ int BaronyTitle::GetProvinceId() const {
 
 void BaronyTitle::SetProvinceId(int id) {
     m_ProvinceId = id;
+    if(m_Hierarchy != nullptr)
+        m_Hierarchy->SetModified(*this);
 }
 
 bool BaronyTitle::HasSelectionFocus() const {
@@ -247,7 +322,8 @@ bool BaronyTitle::HasSelectionFocus() const {
 }
 
 sf::Vector2i BaronyTitle::GetImagePosition(SharedPtr<Mod> mod) const {
-    return mod->GetProvincesByIds()[m_ProvinceId]->GetImagePosition();
+    const SharedPtr<Province>& province = mod->GetProvinceById(m_ProvinceId);
+    return (province == nullptr) ? sf::Vector2i(0, 0) : province->GetImagePosition();
 }
 
 CountyTitle::CountyTitle() : HighTitle() {}
@@ -276,4 +352,300 @@ EmpireTitle::EmpireTitle(std::string name, sf::Color color, bool landless) : Hig
 
 TitleType EmpireTitle::GetType() const {
     return TitleType::EMPIRE;
-}
\ No newline at end of file
+}
+
+TitlesHierarchy::~TitlesHierarchy() {
+    // Titles may outlive the hierarchy, detach them from it.
+    for(const auto& title : m_Titles) {
+        if(title != nullptr) {
+            title->m_Id = -1;
+            title->m_Hierarchy = nullptr;
+        }
+    }
+}
+
+void TitlesHierarchy::Add(const SharedPtr<Title>& title) {
+    if(title == nullptr || title->m_Hierarchy == this)
+        return;
+    if(title->m_Hierarchy != nullptr)
+        title->m_Hierarchy->Remove(title);
+
+    int id = m_Titles.size();
+    if(!m_FreeIds.empty()) {
+        id = m_FreeIds.back();
+        m_FreeIds.pop_back();
+    }
+    else {
+        m_Titles.emplace_back();
+        m_Lieges.push_back(-1);
+        m_Ancestors.emplace_back();
+    }
+    m_Titles[id] = title;
+    title->m_Id = id;
+    title->m_Hierarchy = this;
+    m_References.AddTitle(*title);
+    m_ModifiedTitles.set(id);
+
+    // The dejure titles may have been added before their liege (see Mod::ParseTitles).
+    this->Update(*title);
+}
+
+void TitlesHierarchy::Remove(const SharedPtr<Title>& title) {
+    if(title == nullptr || title->m_Hierarchy != this)
+        return;
+
+    m_References.RemoveTitle(*title);
+
+    const int id = title->m_Id;
+    m_ModifiedTitles.set(id);
+    if(m_Lieges[id] >= 0)
+        m_ModifiedTitles.set(m_Lieges[id]);
+
+    title->m_Id = -1;
+    title->m_Hierarchy = nullptr;
+    m_Titles[id] = nullptr;
+    m_Lieges[id] = -1;
+    m_Ancestors[id].fill(-1);
+    m_FreeIds.push_back(id);
+
+    // Dejure titles still pointing to the title lose their ancestors above it.
+    if(!title->Is(TitleType::BARONY)) {
+        for(const auto& dejureTitle : StaticCastSharedPtr<HighTitle>(title)->GetDejureTitles()) {
+            if(dejureTitle->m_Hierarchy == this)
+                this->Update(*dejureTitle);
+        }
+    }
+}
+
+void TitlesHierarchy::Update(Title& title) {
+    if(title.m_Hierarchy != this)
+        return;
+
+    const SharedPtr<HighTitle>& liege = title.GetLiegeTitle();
+    const int liegeId = (liege != nullptr && liege->m_Hierarchy == this) ? liege->m_Id : -1;
+
+    auto& ancestors = m_Ancestors[title.m_Id];
+    if(liegeId >= 0) ancestors = m_Ancestors[liegeId];
+    else ancestors.fill(-1);
+
+    // A liege of a lower or equal tier (from invalid files) is
+    // kept as liege but can't be an ancestor of its tier.
+    for(int type = 0; type <= (int) title.GetType(); type++)
+        ancestors[type] = -1;
+    ancestors[(int) title.GetType()] = title.m_Id;
+
+    const int previousLiegeId = m_Lieges[title.m_Id];
+    if(previousLiegeId != liegeId) {
+        m_ModifiedTitles.set(title.m_Id);
+        if(previousLiegeId >= 0) m_ModifiedTitles.set(previousLiegeId);
+        if(liegeId >= 0) m_ModifiedTitles.set(liegeId);
+    }
+    m_Lieges[title.m_Id] = liegeId;
+
+    if(!title.Is(TitleType::BARONY)) {
+        for(const auto& dejureTitle : static_cast<HighTitle&>(title).GetDejureTitles()) {
+            if(dejureTitle->GetLiegeTitle().get() == &title)
+                this->Update(*dejureTitle);
+        }
+    }
+}
+
+uint TitlesHierarchy::GetCount() const {
+    return m_Titles.size() - m_FreeIds.size();
+}
+
+const SharedPtr<Title>& TitlesHierarchy::GetTitle(int id) const {
+    static const SharedPtr<Title> none = nullptr;
+    return (id < 0 || id >= (int) m_Titles.size()) ? none : m_Titles[id];
+}
+
+int TitlesHierarchy::GetLiegeId(int id) const {
+    return (id < 0 || id >= (int) m_Lieges.size()) ? -1 : m_Lieges[id];
+}
+
+int TitlesHierarchy::GetAncestorId(int id, TitleType type) const {
+    if(id < 0 || id >= (int) m_Ancestors.size() || (int) type < 0 || (int) type >= (int) TitleType::COUNT)
+        return -1;
+    return m_Ancestors[id][(int) type];
+}
+
+const SharedPtr<Title>& TitlesHierarchy::GetAncestor(int id, TitleType type) const {
+    return this->GetTitle(this->GetAncestorId(id, type));
+}
+
+TitleReferences& TitlesHierarchy::GetReferences() {
+    return m_References;
+}
+
+const TitleReferences& TitlesHierarchy::GetReferences() const {
+    return m_References;
+}
+
+void TitlesHierarchy::SetModified(const Title& title) {
+    if(title.m_Hierarchy == this)
+        m_ModifiedTitles.set(title.m_Id);
+}
+
+Bitset TitlesHierarchy::TakeModifiedTitles() {
+    Bitset modifiedTitles;
+    std::swap(modifiedTitles, m_ModifiedTitles);
+    return modifiedTitles;
+}
+
+bool TitleReference::operator<(const TitleReference& other) const {
+    if(title != other.title)
+        return title < other.title;
+    if(type != other.type)
+        return type < other.type;
+    return date < other.date;
+}
+
+const std::set<TitleReference>& TitleReferences::Get(const std::string& name) const {
+    static const std::set<TitleReference> none;
+    const auto& it = m_References.find(name);
+    return (it == m_References.end()) ? none : it->second;
+}
+
+const std::unordered_map<std::string, std::set<TitleReference>>& TitleReferences::GetAll() const {
+    return m_References;
+}
+
+void TitleReferences::Add(const std::string& name, const TitleReference& reference) {
+    m_References[name].insert(reference);
+}
+
+void TitleReferences::Remove(const std::string& name, const TitleReference& reference) {
+    const auto& it = m_References.find(name);
+    if(it == m_References.end())
+        return;
+    it->second.erase(reference);
+    if(it->second.empty())
+        m_References.erase(it);
+}
+
+void TitleReferences::Rename(const std::string& formerName, const std::string& name) {
+    const auto& it = m_References.find(formerName);
+    if(it == m_References.end() || formerName == name)
+        return;
+    std::set<TitleReference> references = std::move(it->second);
+    m_References.erase(it);
+    m_References[name].merge(references);
+}
+
+void TitleReferences::AddTitle(Title& title) {
+    for(const auto& [date, data] : title.GetHistory())
+        this->AddHistory(title, date, data);
+    for(const auto& [culture, name] : title.GetCulturalNames())
+        this->Add(culture, { ReferenceType::CULTURAL_NAME, &title });
+    if(!title.Is(TitleType::BARONY)) {
+        const SharedPtr<CountyTitle>& capital = static_cast<HighTitle&>(title).GetCapitalTitle();
+        if(capital != nullptr)
+            this->Add(capital->GetName(), { ReferenceType::CAPITAL, &title });
+    }
+}
+
+void TitleReferences::RemoveTitle(Title& title) {
+    for(const auto& [date, data] : title.GetHistory())
+        this->RemoveHistory(title, date, data);
+    for(const auto& [culture, name] : title.GetCulturalNames())
+        this->Remove(culture, { ReferenceType::CULTURAL_NAME, &title });
+    if(!title.Is(TitleType::BARONY)) {
+        const SharedPtr<CountyTitle>& capital = static_cast<HighTitle&>(title).GetCapitalTitle();
+        if(capital != nullptr)
+            this->Remove(capital->GetName(), { ReferenceType::CAPITAL, &title });
+    }
+}
+
+// Name of the title referenced by a key of a history entry, empty if there is none.
+static std::string GetHistoryReference(const SharedPtr<Parser::Object>& data, const std::string& key) {
+    if(data == nullptr || !data->Is(Parser::ObjectType::OBJECT) || !data->ContainsKey(key))
+        return "";
+    const SharedPtr<Parser::Object> value = data->GetObject(key);
+    return value->Is(Parser::ObjectType::STRING) ? (std::string) *value : "";
+}
+
+void TitleReferences::AddHistory(Title& title, Date date, const SharedPtr<Parser::Object>& data) {
+    const std::string liege = GetHistoryReference(data, "liege");
+    if(!liege.empty())
+        this->Add(liege, { ReferenceType::LIEGE, &title, date });
+    const std::string dejureLiege = GetHistoryReference(data, "de_jure_liege");
+    if(!dejureLiege.empty())
+        this->Add(dejureLiege, { ReferenceType::DE_JURE_LIEGE, &title, date });
+}
+
+void TitleReferences::RemoveHistory(Title& title, Date date, const SharedPtr<Parser::Object>& data) {
+    const std::string liege = GetHistoryReference(data, "liege");
+    if(!liege.empty())
+        this->Remove(liege, { ReferenceType::LIEGE, &title, date });
+    const std::string dejureLiege = GetHistoryReference(data, "de_jure_liege");
+    if(!dejureLiege.empty())
+        this->Remove(dejureLiege, { ReferenceType::DE_JURE_LIEGE, &title, date });
+}
+
+InheritedAttributes::InheritedAttributes(ProvincesIndex& provinces, TitlesHierarchy& titles, const std::map<int, SharedPtr<BaronyTitle>>& baronies)
+: m_Provinces(provinces), m_Titles(titles), m_Baronies(baronies)
+{}
+
+uint InheritedAttributes::GetAttributeId(ProvinceAttribute attribute, int provinceId) {
+    const std::vector<uint>& ids = m_Provinces.GetAttributeColumn(attribute);
+    if(provinceId < 0 || provinceId >= (int) ids.size())
+        return 0;
+    if(ids[provinceId] != 0)
+        return ids[provinceId];
+    const int countyId = this->GetCountyId(provinceId);
+    return (countyId < 0) ? 0 : this->GetCountyAttributeId(attribute, countyId);
+}
+
+bool InheritedAttributes::IsInherited(ProvinceAttribute attribute, int provinceId) {
+    const std::vector<uint>& ids = m_Provinces.GetAttributeColumn(attribute);
+    return provinceId >= 0 && provinceId < (int) ids.size() && ids[provinceId] == 0 && this->GetAttributeId(attribute, provinceId) != 0;
+}
+
+int InheritedAttributes::GetCountyId(int provinceId) const {
+    const auto& it = m_Baronies.find(provinceId);
+    return (it == m_Baronies.end()) ? -1 : m_Titles.GetAncestorId(it->second->GetId(), TitleType::COUNTY);
+}
+
+uint InheritedAttributes::GetCountyAttributeId(ProvinceAttribute attribute, int countyId) {
+    this->Refresh();
+
+    std::vector<uint>& counties = m_Counties[(int) attribute];
+    Bitset& resolved = m_Resolved[(int) attribute];
+    if(resolved.test(countyId))
+        return counties[countyId];
+
+    if(countyId >= (int) counties.size())
+        counties.resize(countyId + 1, 0);
+    counties[countyId] = 0;
+
+    const std::vector<uint>& ids = m_Provinces.GetAttributeColumn(attribute);
+    const SharedPtr<HighTitle>& county = StaticCastSharedPtr<HighTitle>(m_Titles.GetTitle(countyId));
+    for(const auto& dejureTitle : county->GetDejureTitles()) {
+        const uint provinceId = StaticCastSharedPtr<BaronyTitle>(dejureTitle)->GetProvinceId();
+        if(provinceId < ids.size() && ids[provinceId] != 0) {
+            counties[countyId] = ids[provinceId];
+            break;
+        }
+    }
+    resolved.set(countyId);
+    return counties[countyId];
+}
+
+void InheritedAttributes::Invalidate(int countyId) {
+    if(countyId < 0)
+        return;
+    for(Bitset& resolved : m_Resolved)
+        resolved.set(countyId, false);
+}
+
+void InheritedAttributes::Refresh() {
+    // A province changing affects the provinces of its county, and a title changing
+    // affects its county (for baronies) or itself (for counties losing or gaining baronies).
+    m_Provinces.TakeModifiedProvinces().for_each([&](uint provinceId) {
+        this->Invalidate(this->GetCountyId(provinceId));
+    });
+    m_Titles.TakeModifiedTitles().for_each([&](uint titleId) {
+        this->Invalidate(titleId);
+        this->Invalidate(m_Titles.GetAncestorId(titleId, TitleType::COUNTY));
+    });
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+class TitlesHierarchy;
+
 class Title {
 friend PropertiesTab;
+friend TitlesHierarchy;
 public:
     Title();
     Title(std::string name, sf::Color color, bool landless = false);
@@ -12,6 +15,7 @@ public:
     // Title& operator=(Title&& other) = delete;
 
     virtual TitleType GetType() const = 0;
+    int GetId() const;
     std::string GetName() const;
     sf::Color GetColor() const;
     SharedPtr<HighTitle>& GetLiegeTitle();
@@ -25,35 +29,32 @@ public:
     void SetLiegeTitle(SharedPtr<HighTitle> title);
     void SetLandless(bool landless);
     
-    std::string GetOriginalFilePath() const;
+    // The file paths and localization are stored in pools of the mod
+    // (see Mod::GetFilePaths and Mod::GetLocalizationStrings).
+    uint GetOriginalFilePathId() const;
+    File::Span GetOriginalSpan() const;
+    uint64_t GetOriginalHash() const;
     SharedPtr<Parser::Object> GetOriginalData() const;
-    void SetOriginalFilePath(const std::string& filePath);
-    void SetOriginalData(SharedPtr<Parser::Object> data);
+    void SetOriginalFilePathId(uint filePath);
+    void SetOriginalSpan(File::Span span, uint64_t hash);
+    void SetOriginalData(SharedPtr<Parser::Object> data, uint64_t hash);
 
-    std::string GetOriginalHistoryFilePath() const;
-    void SetOriginalHistoryFilePath(const std::string& filePath);
-    std::map<Date, SharedPtr<Parser::Object>>& GetHistory();
+    uint GetOriginalHistoryFilePathId() const;
+    void SetOriginalHistoryFilePathId(uint filePath);
+    FlatMap<Date, SharedPtr<Parser::Object>>& GetHistory();
     void AddHistory(Date date, SharedPtr<Parser::Object> data);
     void RemoveHistory(Date date);
 
-    std::map<std::string, std::string>& GetCulturalNames();
+    FlatMap<std::string, std::string>& GetCulturalNames();
     void AddCulturalName(const std::string& culture, std::string name);
     void RemoveCulturalName(const std::string& culture);
 
-    std::map<std::string, std::string>& GetLocNames();
-    std::string& GetLocName(const std::string& lang);
-    std::string GetLocName(const std::string& lang) const;
-    void SetLocName(const std::string& lang, std::string name);
-
-    std::map<std::string, std::string>& GetLocAdjectives();
-    std::string& GetLocAdjective(const std::string& lang);
-    std::string GetLocAdjective(const std::string& lang) const;
-    void SetLocAdjective(const std::string& lang, std::string adjective);
-    
-    std::map<std::string, std::string>& GetLocArticles();
-    std::string& GetLocArticle(const std::string& lang);
-    std::string GetLocArticle(const std::string& lang) const;
-    void SetLocArticle(const std::string& lang, std::string article);
+    std::string GetLocName(const StringPool& strings, const std::string& lang) const;
+    void SetLocName(StringPool& strings, const std::string& lang, const std::string& name);
+    std::string GetLocAdjective(const StringPool& strings, const std::string& lang) const;
+    void SetLocAdjective(StringPool& strings, const std::string& lang, const std::string& adjective);
+    std::string GetLocArticle(const StringPool& strings, const std::string& lang) const;
+    void SetLocArticle(StringPool& strings, const std::string& lang, const std::string& article);
 
     virtual bool HasSelectionFocus() const;
     virtual void SetSelectionFocus(bool focus);
@@ -66,18 +67,39 @@ protected:
     SharedPtr<HighTitle> m_LiegeTitle;
     bool m_Landless;
 
-    std::string m_OriginalFilePath;
+    // Id of the title in the hierarchy of the mod updated when
+    // its liege changes (see TitlesHierarchy), -1 if there is none.
+    int m_Id;
+    TitlesHierarchy* m_Hierarchy;
+
+    // Ids of the original files paths in the file paths of the mod.
+    uint m_OriginalFilePath;
+    uint m_OriginalHistoryFilePath;
+
+    // Block of the definition in the original file, read back when exporting.
+    // The parsed data is only kept if there is no such block, and the hash
+    // of the block checks that it wasn't modified, see Province.
+    File::Span m_OriginalSpan;
+    uint64_t m_OriginalHash;
     SharedPtr<Parser::Object> m_OriginalData;
 
-    std::string m_OriginalHistoryFilePath;
-    std::map<Date, SharedPtr<Parser::Object>> m_History;
-    std::map<std::string, std::string> m_CulturalNames;
+    // Titles usually have a few dates and cultural names, and a single language.
+    FlatMap<Date, SharedPtr<Parser::Object>> m_History;
+    FlatMap<std::string, std::string> m_CulturalNames;
 
-    std::map<std::string, std::string> m_LocNames;
-    std::map<std::string, std::string> m_LocAdjectives;
-    std::map<std::string, std::string> m_LocArticles;
+    // Ids of the localization strings of each language (by id), in the localization strings of the mod.
+    struct Localization {
+        uint name = 0;
+        uint adjective = 0;
+        uint article = 0;
+    };
+    FlatMap<uint, Localization> m_Localization;
 
     bool m_SelectionFocus;
+
+private:
+    std::string GetLocalization(const StringPool& strings, const std::string& lang, uint Localization::* field) const;
+    void SetLocalization(StringPool& strings, const std::string& lang, uint Localization::* field, const std::string& value);
 };
 
 class HighTitle : public Title, public std::enable_shared_from_this<HighTitle> {
@@ -159,6 +181,111 @@ public:
     virtual TitleType GetType() const;
 };
 
+enum class ReferenceType {
+    LIEGE,
+    DE_JURE_LIEGE,
+    CAPITAL,
+    CULTURAL_NAME,
+};
+
+// Place in a title referencing another title or a culture by name:
+// a liege in its history at a date, its capital or one of its cultural names.
+struct TitleReference {
+    ReferenceType type;
+    Title* title;
+    Date date = Date(0, 0, 0);
+
+    bool operator<(const TitleReference& other) const;
+};
+
+// Places referencing each title and culture name, updated by the titles
+// registered in a TitlesHierarchy, to rename or delete a title by only
+// touching its references and to find references to undefined names.
+class TitleReferences {
+public:
+    const std::set<TitleReference>& Get(const std::string& name) const;
+    const std::unordered_map<std::string, std::set<TitleReference>>& GetAll() const;
+
+    void Add(const std::string& name, const TitleReference& reference);
+    void Remove(const std::string& name, const TitleReference& reference);
+    void Rename(const std::string& formerName, const std::string& name);
+
+    void AddTitle(Title& title);
+    void RemoveTitle(Title& title);
+    void AddHistory(Title& title, Date date, const SharedPtr<Parser::Object>& data);
+    void RemoveHistory(Title& title, Date date, const SharedPtr<Parser::Object>& data);
+
+private:
+    std::unordered_map<std::string, std::set<TitleReference>> m_References;
+};
+
+// Titles of the mod with dense ids, the id of their liege and of their
+// ancestor of each tier, to find the county or empire of a barony with a
+// table read. The ancestors of a title and its dejure titles are updated
+// when its liege changes (see Title::SetLiegeTitle).
+class TitlesHierarchy {
+public:
+    ~TitlesHierarchy();
+
+    void Add(const SharedPtr<Title>& title);
+    void Remove(const SharedPtr<Title>& title);
+    void Update(Title& title);
+
+    uint GetCount() const;
+    const SharedPtr<Title>& GetTitle(int id) const;
+    int GetLiegeId(int id) const;
+    int GetAncestorId(int id, TitleType type) const;
+    const SharedPtr<Title>& GetAncestor(int id, TitleType type) const;
+
+    TitleReferences& GetReferences();
+    const TitleReferences& GetReferences() const;
+
+    // Ids of the titles added, removed or moved to another liege, of their
+    // previous and new lieges and of the baronies whose province changed
+    // since the last call, to update the data computed from them.
+    void SetModified(const Title& title);
+    Bitset TakeModifiedTitles();
+
+private:
+    std::vector<SharedPtr<Title>> m_Titles;
+    std::vector<int> m_Lieges;
+    std::vector<std::array<int, (int) TitleType::COUNT>> m_Ancestors;
+
+    // Ids of removed titles, reused by the next titles added.
+    std::vector<int> m_FreeIds;
+
+    TitleReferences m_References;
+    Bitset m_ModifiedTitles;
+};
+
+// Culture and religion of the provinces, which inherit the ones of the capital
+// of their county (its first barony having one) if they don't have their own.
+// The inherited ids are cached for each county until its baronies or their
+// provinces change (see TitlesHierarchy::TakeModifiedTitles).
+class InheritedAttributes {
+public:
+    InheritedAttributes(ProvincesIndex& provinces, TitlesHierarchy& titles, const std::map<int, SharedPtr<BaronyTitle>>& baronies);
+
+    // Id of the attribute of a province, or of the one it inherits
+    // from its county if it doesn't have one (0 if there is none).
+    uint GetAttributeId(ProvinceAttribute attribute, int provinceId);
+    bool IsInherited(ProvinceAttribute attribute, int provinceId);
+
+private:
+    int GetCountyId(int provinceId) const;
+    uint GetCountyAttributeId(ProvinceAttribute attribute, int countyId);
+    void Invalidate(int countyId);
+    void Refresh();
+
+    ProvincesIndex& m_Provinces;
+    TitlesHierarchy& m_Titles;
+    const std::map<int, SharedPtr<BaronyTitle>>& m_Baronies;
+
+    // Inherited id of each attribute by county id, if its bit is set in m_Resolved.
+    std::array<std::vector<uint>, (int) ProvinceAttribute::COUNT> m_Counties;
+    std::array<Bitset, (int) ProvinceAttribute::COUNT> m_Resolved;
+};
+
 template <typename ...Args>
 inline SharedPtr<Title> MakeTitle(TitleType type, Args&& ...args) {
     switch(type) {
@@ -14,6 +14,10 @@ EditorMenu::EditorMenu(App* app)
 : Menu(app, "Editor"),
 m_MapMode(MapMode::PROVINCES),
 m_SelectionHandler(SelectionHandler(this)),
+m_SpriteTextureMode(MapMode::PROVINCES),
+m_BordersTexture(TiledTexture::GetTileSize() / 4, TiledTexture::GetTileSize()),
+m_OutdatedArea(0, 0, 0, 0),
+m_OutdatedTitlesColors(false),
 m_DisplayBorders(true),
 m_ExitToMainMenu(false)
 {
@@ -44,19 +48,8 @@ SharedPtr<Province> EditorMenu::GetHoveredProvince() {
     sf::Vector2f mousePosition = m_App->GetWindow().mapPixelToCoords(sf::Mouse::getPosition(m_App->GetWindow()));
     ToggleCamera(false);
 
-    if(!m_MapSprite.getGlobalBounds().contains(mousePosition))
-        return nullptr;
-
-    SharedPtr<Mod> mod = m_App->GetMod();
-    sf::Vector2f mapMousePosition = mousePosition - m_MapSprite.getPosition();
-
-    sf::Color color = mod->GetProvinceImage().getPixel(mapMousePosition.x, mapMousePosition.y);
-    uint32_t colorId = color.toInteger();
-
-    if(mod->GetProvinces().count(colorId) == 0)
-        return nullptr;
-        
-    return mod->GetProvinces()[colorId];
+    // Read the province id of the pixel under the mouse, positions outside of the map have no province.
+    return m_App->GetMod()->GetProvinceAt(sf::Vector2i(std::floor(mousePosition.x), std::floor(mousePosition.y)));
 }
 
 MapMode EditorMenu::GetMapMode() const {
@@ -82,7 +75,18 @@ void EditorMenu::UpdateHoveringText() {
     || m_MapMode == MapMode::TERRAIN
     || m_MapMode == MapMode::CULTURE
     || m_MapMode == MapMode::RELIGION) {
-        m_HoverText.setString(fmt::format("#{} ({})", province->GetId(), province->GetName()));
+        std::string text = fmt::format("#{} ({})", province->GetId(), province->GetName());
+
+        // Show the culture or religion of the province, which may be the one of its county.
+        if(m_MapMode == MapMode::CULTURE || m_MapMode == MapMode::RELIGION) {
+            const SharedPtr<Mod>& mod = m_App->GetMod();
+            const ProvinceAttribute attribute = (m_MapMode == MapMode::CULTURE) ? ProvinceAttribute::CULTURE : ProvinceAttribute::RELIGION;
+            const StringPool& names = (m_MapMode == MapMode::CULTURE) ? mod->GetCultureNames() : mod->GetReligionNames();
+            const uint id = mod->GetInheritedAttributes().GetAttributeId(attribute, province->GetId());
+            if(id != 0)
+                text += fmt::format("\n{}{}", names.Get(id), mod->GetInheritedAttributes().IsInherited(attribute, province->GetId()) ? " (county)" : "");
+        }
+        m_HoverText.setString(text);
         m_HoverText.setPosition({(float) mousePosition.x + 5, (float) mousePosition.y - m_HoverText.getGlobalBounds().height - 10});
         m_HoverText.setFillColor(brightenColor(province->GetColor()));
         return;
@@ -114,7 +118,7 @@ void EditorMenu::ToggleCamera(bool enabled) {
 }
 
 void EditorMenu::SwitchMapMode(MapMode mode, bool clearSelection) {
-    // Update the map sprite with the corresponding map mode.
+    // Draw the map with the texture of the corresponding map mode.
     //
     // This function does not update the base image, EditorMenu::UpdateTexture(mode)
     // needs to be called if any province/title/... has been modified.
@@ -122,82 +126,291 @@ void EditorMenu::SwitchMapMode(MapMode mode, bool clearSelection) {
     m_MapMode = mode;
     if(clearSelection)
         m_SelectionHandler.ClearSelection();
-    m_MapSprite.setTexture(m_MapTextures[m_MapMode]);
+
+    // Title map modes draw the provinces texture, the colors of the titles
+    // are looked up by the shader from the ids of the provinces.
+    MapMode textureMode = MapModeIsTitle(m_MapMode) ? MapMode::PROVINCES : m_MapMode;
+
+    // Textures are generated the first time their map mode is shown (or after being
+    // evicted), the previous texture is displayed until it is ready.
+    if(m_MapTextures.count(textureMode) == 0) {
+        if(m_PendingImages.count(textureMode) == 0)
+            this->UpdateTexture(textureMode);
+        if(m_MapTextures.count(textureMode) == 0)
+            return;
+    }
+
+    m_TexturesUsage.remove(textureMode);
+    m_TexturesUsage.push_back(textureMode);
+    m_SpriteTextureMode = textureMode;
 }
 
 void EditorMenu::RefreshMapMode(bool clearSelection, bool resetFocus) {
     // Recreate the image for the current map mode, update the shader
-    // and update the map sprite on the screen.
+    // and update the map drawn on the screen.
     this->UpdateTexture(m_MapMode, resetFocus);
     this->SwitchMapMode(m_MapMode, clearSelection);
+
+    // The provinces highlighted by the selected titles depend on the hierarchy.
+    if(!clearSelection)
+        m_SelectionHandler.Update();
 }
 
 void EditorMenu::UpdateTexture(MapMode mode, bool resetFocus) {
     // Update the pixels of the specified image (from scratch) and then
     // update the corresponding texture in the shader.
+    //
+    // The map modes generated from every pixel of the map are generated
+    // in the background, see EditorMenu::SwapTextures. The provinces texture
+    // and the titles colors are uploaded directly.
+    std::function<std::vector<sf::Image>()> generate = this->PrepareImages(mode, resetFocus);
+
+    if(mode == MapMode::PROVINCES || MapModeIsTitle(mode)) {
+        this->UploadTextures(mode, generate());
+        return;
+    }
+
+    // A previous generation of the same map mode is outdated, its images are discarded.
+    SharedPtr<PendingImages> pending = MakeShared<PendingImages>();
+    pending->task = ThreadPool::Get()->Submit([pending, generate]() {
+        pending->images = generate();
+    });
+    m_PendingImages[mode] = pending;
+}
+
+void EditorMenu::UpdateTextures() {
+    // Update the textures used by all map modes: the provinces texture,
+    // the titles colors and borders. The textures of other map modes are
+    // generated when they are shown (see EditorMenu::SwitchMapMode).
+    this->UpdateTexture(MapMode::PROVINCES);
+    this->UpdateTexture(MapMode::BARONY);
+}
+
+std::function<std::vector<sf::Image>()> EditorMenu::PrepareImages(MapMode mode, bool resetFocus) {
+    // Read everything needed from the provinces/titles on the main thread and
+    // return the function generating the images of a map mode, which can run
+    // in the background. The provinces image is not generated and is uploaded
+    // directly from the mod.
     const SharedPtr<Mod>& mod = m_App->GetMod();
+
+    // The provinces are mapped through the ids image, which unlike the provinces
+    // image (see Mod::SetProvinceColor) is never modified on the main thread.
+    const auto& MapProvinceImage = [mod](std::vector<sf::Uint32> colors) {
+        return [idsImage = mod->GetSharedProvinceIdsImage(), colors = std::move(colors)]() {
+            const sf::IntRect area = sf::IntRect(0, 0, idsImage->getSize().x, idsImage->getSize().y);
+            return std::vector<sf::Image> { Image::MapIds(*idsImage, area, colors) };
+        };
+    };
+
     switch(mode) {
-        case MapMode::PROVINCES:
-            // TODO: update pixel colors in mod->m_ProvinceImage
-            m_MapTextures[mode].loadFromImage(mod->GetProvinceImage());
-            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("provincesTexture", m_MapTextures[mode]);
-            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("textureSize", sf::Vector2f(m_MapTextures[mode].getSize()));
-            break;
         case MapMode::HEIGHTMAP:
-            m_MapTextures[mode].loadFromImage(mod->GetHeightmapImage());
-            break;
+            // The compact heightmap and rivers are only expanded to RGBA for the upload.
+            return [mod]() { return std::vector<sf::Image> { mod->GetHeightmapImage() }; };
         case MapMode::RIVERS:
-            m_MapTextures[mode].loadFromImage(mod->GetRiversImage());
-            break;
+            return [mod]() { return std::vector<sf::Image> { mod->GetRiversImage() }; };
         case MapMode::TERRAIN:
-            m_MapTextures[mode].loadFromImage(mod->GetTerrainImage());
-            break;
+            return MapProvinceImage(mod->GetTerrainColors());
         case MapMode::CULTURE:
-            m_MapTextures[mode].loadFromImage(mod->GetCultureImage());
-            break;
+            return MapProvinceImage(mod->GetCultureColors());
         case MapMode::RELIGION:
-            m_MapTextures[mode].loadFromImage(mod->GetReligionImage());
-            break;
+            return MapProvinceImage(mod->GetReligionColors());
         case MapMode::BARONY:
         case MapMode::COUNTY:
         case MapMode::DUCHY:
         case MapMode::KINGDOM:
         case MapMode::EMPIRE: {
-            TitleType type = MapModeToTileType(mode);
-            m_MapTextures[mode].loadFromImage(mod->GetTitleImage(type));
-            Configuration::shaders.Get(Shaders::PROVINCES).setUniform(
-                String::ToLowercase(TitleTypeLabels[(int) type]) + "Texture",
-                m_MapTextures[mode]
-            );
-
             // Reset the selection focus for every titles of that tier or below.
+            // Otherwise the focused titles have already been updated by the caller
+            // (see Mod::UpdateProvincesFocusedTitles(title)).
             if(resetFocus) {
-                for(const auto& title : mod->GetTitlesByType()[type]) {
+                for(const auto& title : mod->GetTitlesByType()[MapModeToTileType(mode)]) {
                     title->SetSelectionFocus(true);
                 }
+                mod->UpdateProvincesFocusedTitles();
             }
-            break;
+
+            // The colors of all tiers are stored in the same table, so the other
+            // map modes are never outdated.
+            sf::Image titlesColors = mod->GetTitlesColorsImage();
+            return [titlesColors]() { return std::vector<sf::Image> { titlesColors }; };
         }
         default:
+            return []() { return std::vector<sf::Image>(); };
+    }
+}
+
+void EditorMenu::UploadTextures(MapMode mode, std::vector<sf::Image> images) {
+    const SharedPtr<Mod>& mod = m_App->GetMod();
+    switch(mode) {
+        case MapMode::PROVINCES:
+            m_MapTextures[mode].LoadFromImage(mod->GetProvinceImage());
+            m_ProvinceIdsTexture.LoadFromImage(mod->GetProvinceIdsImage());
+            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("mapSize", sf::Vector2f(m_MapTextures[mode].GetSize()));
             break;
-    }   
+        case MapMode::HEIGHTMAP:
+        case MapMode::RIVERS:
+        case MapMode::TERRAIN:
+        case MapMode::CULTURE:
+        case MapMode::RELIGION:
+            m_MapTextures[mode].LoadFromImage(std::move(images[0]));
+            break;
+        case MapMode::BARONY:
+        case MapMode::COUNTY:
+        case MapMode::DUCHY:
+        case MapMode::KINGDOM:
+        case MapMode::EMPIRE:
+            m_TitlesColorsTexture.loadFromImage(images[0]);
+            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("titlesColorsTexture", m_TitlesColorsTexture);
+            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("titlesColorsTextureSize", sf::Vector2f(m_TitlesColorsTexture.getSize()));
+            this->UpdateBordersTexture();
+            return;
+        default:
+            return;
+    }
+
+    if(std::find(m_TexturesUsage.begin(), m_TexturesUsage.end(), mode) == m_TexturesUsage.end())
+        m_TexturesUsage.push_front(mode);
+    this->EvictTextures();
 }
 
-void EditorMenu::UpdateTextures() {
-    // Update the textures for all map modes. This includes:
-    // - Redraw titles/provinces image pixels (with colors from Province/Title objects).
-    // - Update titles and provinces textures in the shader.
-    std::vector<UniquePtr<sf::Thread>> threads;
+void EditorMenu::EvictTextures() {
+    // Release the least recently shown textures until they fit in the memory budget,
+    // counting both the uploaded tiles and the images kept for the tiles not shown yet.
+    // They are generated again from the mod the next time they are shown. The
+    // provinces texture is always kept as it is used by the title map modes,
+    // as well as the textures displayed or about to be displayed.
+    uint64_t usedMemory = 0;
+    for(const auto& [mode, texture] : m_MapTextures)
+        usedMemory += texture.GetMemoryUsage();
+
+    for(auto it = m_TexturesUsage.begin(); it != m_TexturesUsage.end() && usedMemory > Configuration::mapTexturesMemoryBudget;) {
+        MapMode mode = *it;
+        if(mode == MapMode::PROVINCES || mode == m_SpriteTextureMode || mode == m_MapMode) {
+            it++;
+            continue;
+        }
+        usedMemory -= m_MapTextures[mode].GetMemoryUsage();
+        m_MapTextures.erase(mode);
+        it = m_TexturesUsage.erase(it);
+    }
+}
+
+void EditorMenu::UpdateBordersTexture() {
+    // Upload the area of the border mask that changed since the last upload.
+    // The mask has one byte per pixel, packed by 4 in the RGBA texels.
+    const SharedPtr<Mod>& mod = m_App->GetMod();
+    sf::IntRect area = mod->FlushBorderMaskUpdates();
+
+    if(area.width <= 0 || area.height <= 0)
+        return;
+
+    const std::vector<sf::Uint8>& mask = mod->GetBorderMask();
+    const uint stride = mod->GetBorderMaskStride();
+    const sf::Vector2u size = sf::Vector2u(stride / 4, mod->GetProvinceImage().getSize().y);
 
-    for(MapMode mode = MapMode::PROVINCES; mode < MapMode::COUNT; mode = (MapMode)((int) mode + 1)) {
-        threads.push_back(MakeUnique<sf::Thread>([&, mode](){
-            this->UpdateTexture(mode);
-        }));
-        threads[threads.size()-1]->launch();
+    if(m_BordersTexture.GetSize() != size) {
+        m_BordersTexture.Create(size);
+        area = sf::IntRect(0, 0, stride, size.y);
     }
 
-    for(auto& thread : threads)
-        thread->wait();
+    uint left = area.left / 4;
+    uint right = (area.left + area.width + 3) / 4;
+
+    if(left == 0 && right == size.x) {
+        m_BordersTexture.Update(&mask[area.top * stride], size.x, area.height, 0, area.top);
+    }
+    else {
+        std::vector<sf::Uint8> pixels((right - left) * 4 * area.height);
+        for(int y = 0; y < area.height; y++)
+            std::copy_n(&mask[(area.top + y) * stride + left * 4], (right - left) * 4, &pixels[y * (right - left) * 4]);
+        m_BordersTexture.Update(pixels.data(), right - left, area.height, left, area.top);
+    }
+}
+
+void EditorMenu::InvalidateProvince(const SharedPtr<Province>& province) {
+    // Mark the pixels of a province to be redrawn at the next frame, after its
+    // terrain, culture, religion... changed. The other provinces of its county
+    // are redrawn too as they inherit its culture and religion if they have none.
+    const SharedPtr<Mod>& mod = m_App->GetMod();
+    if(province->GetImagePixelsCount() > 0)
+        m_OutdatedArea = Math::UnionRect(m_OutdatedArea, province->GetImageBoundingBox());
+
+    const SharedPtr<Title>& county = mod->GetProvinceLiegeTitle(province, TitleType::COUNTY);
+    if(county == nullptr)
+        return;
+
+    for(const auto& dejureTitle : CastSharedPtr<CountyTitle>(county)->GetDejureTitles()) {
+        const SharedPtr<Province>& dejureProvince = mod->GetProvinceById(CastSharedPtr<BaronyTitle>(dejureTitle)->GetProvinceId());
+        if(dejureProvince != nullptr && dejureProvince->GetImagePixelsCount() > 0)
+            m_OutdatedArea = Math::UnionRect(m_OutdatedArea, dejureProvince->GetImageBoundingBox());
+    }
+}
+
+void EditorMenu::InvalidateTitlesColors() {
+    m_OutdatedTitlesColors = true;
+}
+
+void EditorMenu::SwapTextures() {
+    // Upload the images generated in the background that are done, and
+    // the border mask once it has been swapped in (see Mod::FlushBorderMaskUpdates).
+    bool swapped = false;
+    for(auto it = m_PendingImages.begin(); it != m_PendingImages.end();) {
+        if(!it->second->task->IsDone()) {
+            it++;
+            continue;
+        }
+        this->UploadTextures(it->first, std::move(it->second->images));
+        it = m_PendingImages.erase(it);
+        swapped = true;
+    }
+    this->UpdateBordersTexture();
+
+    if(swapped)
+        this->SwitchMapMode(m_MapMode);
+}
+
+void EditorMenu::FlushMapUpdates() {
+    // Apply the modifications of the frame at once: only the pixels of the
+    // area covering the modified provinces are redrawn and uploaded, instead
+    // of generating the images of the whole map again.
+    const SharedPtr<Mod>& mod = m_App->GetMod();
+    this->SwapTextures();
+
+    if(m_OutdatedTitlesColors) {
+        m_OutdatedTitlesColors = false;
+        this->UploadTextures(MapMode::BARONY, { mod->GetTitlesColorsImage() });
+    }
+
+    // Wait for the images generated in the background, the area would be
+    // overwritten when they are uploaded.
+    if(!m_PendingImages.empty())
+        return;
+
+    sf::IntRect area = m_OutdatedArea;
+    m_OutdatedArea = sf::IntRect(0, 0, 0, 0);
+
+    if(area.width <= 0 || area.height <= 0)
+        return;
+
+    // Textures that are not in memory are generated from scratch when shown.
+    const auto& UpdateArea = [&](MapMode mode, const std::function<sf::Image()>& generate) {
+        if(m_MapTextures.count(mode) == 0)
+            return;
+        sf::Image image = generate();
+        m_MapTextures[mode].Update(image, area.left, area.top);
+    };
+
+    // Provinces may have been recolored (see Mod::SetProvinceColor).
+    const sf::Uint8* provincesPixels = mod->GetProvinceImage().getPixelsPtr();
+    const uint width = mod->GetProvinceImage().getSize().x;
+    std::vector<sf::Uint8> pixels(area.width * area.height * 4);
+    for(int y = 0; y < area.height; y++)
+        std::copy_n(provincesPixels + ((area.top + y) * width + area.left) * 4, area.width * 4, &pixels[y * area.width * 4]);
+    m_MapTextures[MapMode::PROVINCES].Update(pixels.data(), area.width, area.height, area.left, area.top);
+
+    UpdateArea(MapMode::TERRAIN, [&]() { return mod->GetTerrainImage(area); });
+    UpdateArea(MapMode::CULTURE, [&]() { return mod->GetCultureImage(area); });
+    UpdateArea(MapMode::RELIGION, [&]() { return mod->GetReligionImage(area); });
 }
 
 void EditorMenu::Update(sf::Time delta) {
@@ -293,6 +506,9 @@ void EditorMenu::Event(const sf::Event& event) {
 void EditorMenu::Render() {
     sf::RenderWindow& window = m_App->GetWindow();
 
+    // Apply the modifications made during the previous frame.
+    this->FlushMapUpdates();
+
     // Update provinces shader
     sf::Shader& provinceShader = Configuration::shaders.Get(Shaders::PROVINCES);
     provinceShader.setUniform("texture", sf::Shader::CurrentTexture);
@@ -301,16 +517,7 @@ void EditorMenu::Render() {
     provinceShader.setUniform("displayBorders", m_DisplayBorders);
 
     ToggleCamera(true);
-
-    if(m_MapMode == MapMode::PROVINCES
-    || m_MapMode == MapMode::TERRAIN
-    || m_MapMode == MapMode::CULTURE
-    || m_MapMode == MapMode::RELIGION
-    || MapModeIsTitle(m_MapMode))
-        window.draw(m_MapSprite, &Configuration::shaders.Get(Shaders::PROVINCES));
-    else 
-        window.draw(m_MapSprite);
-
+    this->RenderMap();
     ToggleCamera(false);
 
     window.draw(m_HoverText);
@@ -333,6 +540,43 @@ void EditorMenu::Render() {
     }
 }
 
+void EditorMenu::RenderMap() {
+    // Only the tiles of the map that are visible by the camera are drawn,
+    // and uploaded the first time they are visible (see TiledTexture).
+    sf::RenderWindow& window = m_App->GetWindow();
+    const sf::View& view = window.getView();
+    sf::FloatRect visibleArea(view.getCenter() - view.getSize() / 2.f, view.getSize());
+
+    bool useShader = m_MapMode == MapMode::PROVINCES
+    || m_MapMode == MapMode::TERRAIN
+    || m_MapMode == MapMode::CULTURE
+    || m_MapMode == MapMode::RELIGION
+    || MapModeIsTitle(m_MapMode);
+
+    sf::Shader& provinceShader = Configuration::shaders.Get(Shaders::PROVINCES);
+    TiledTexture& texture = m_MapTextures[m_SpriteTextureMode];
+
+    for(uint index : texture.GetTiles(visibleArea)) {
+        sf::IntRect bounds = texture.GetTileBounds(index);
+        sf::Sprite sprite(texture.GetTile(index));
+        sprite.setPosition(bounds.left, bounds.top);
+
+        if(!useShader) {
+            window.draw(sprite);
+            continue;
+        }
+
+        // The textures sampled by the shader have the same tiles as the map textures.
+        // Borders are computed on the whole map (see Mod::UpdateBorderMask), so
+        // they don't need to sample the neighbouring tiles.
+        provinceShader.setUniform("provinceIdsTexture", m_ProvinceIdsTexture.GetTile(index));
+        provinceShader.setUniform("bordersTexture", m_BordersTexture.GetTile(index));
+        provinceShader.setUniform("tilePosition", sf::Vector2f(bounds.left, bounds.top));
+        provinceShader.setUniform("tileSize", sf::Vector2f(bounds.width, bounds.height));
+        window.draw(sprite, &provinceShader);
+    }
+}
+
 void EditorMenu::InitSelectionCallbacks() {
     m_SelectionHandler.AddCallback([&](sf::Mouse::Button button, SharedPtr<Province> province) {
         if((m_MapMode != MapMode::PROVINCES && m_MapMode != MapMode::TERRAIN && m_MapMode != MapMode::CULTURE && m_MapMode != MapMode::RELIGION)
@@ -368,6 +612,7 @@ void EditorMenu::InitSelectionCallbacks() {
             if(sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)) {
                 if(!title->Is(TitleType::BARONY)) {
                     title->SetSelectionFocus(false);
+                    m_App->GetMod()->UpdateProvincesFocusedTitles(title);
                     this->RefreshMapMode(true, false);
                 }
                 return SelectionCallbackResult::CONTINUE;
@@ -391,6 +636,7 @@ void EditorMenu::InitSelectionCallbacks() {
         if(button == sf::Mouse::Button::Right) {
             if(title->GetLiegeTitle() != nullptr && !title->GetLiegeTitle()->HasSelectionFocus()) {
                 title->GetLiegeTitle()->SetSelectionFocus(true);
+                m_App->GetMod()->UpdateProvincesFocusedTitles(title->GetLiegeTitle());
                 this->RefreshMapMode(true, false);
             }
         }
@@ -515,6 +761,44 @@ void EditorMenu::RenderMenuBarSelection() {
             m_ModalName = "Harmonize colors";
         }
 
+        // Add all the provinces matching a flag, or sharing an attribute
+        // with one of the selected provinces, to the selection.
+        if(ImGui::BeginMenu("Select provinces")) {
+            const ProvincesIndex& index = m_App->GetMod()->GetProvincesIndex();
+
+            static const std::vector<std::pair<const char*, ProvinceFlags>> flags = {
+                {"Land", ProvinceFlags::LAND},
+                {"Sea zones", ProvinceFlags::SEA},
+                {"Lakes", ProvinceFlags::LAKE},
+                {"Rivers", ProvinceFlags::RIVER},
+                {"Coastal", ProvinceFlags::COASTAL},
+                {"Islands", ProvinceFlags::ISLAND},
+                {"Impassable", ProvinceFlags::IMPASSABLE},
+            };
+            for(const auto& [name, flag] : flags) {
+                if(ImGui::MenuItem(name))
+                    m_SelectionHandler.Select(index.GetFlag(flag));
+            }
+            ImGui::Separator();
+
+            static const std::vector<std::pair<const char*, ProvinceAttribute>> attributes = {
+                {"Same holding", ProvinceAttribute::HOLDING},
+                {"Same terrain", ProvinceAttribute::TERRAIN},
+                {"Same culture", ProvinceAttribute::CULTURE},
+                {"Same religion", ProvinceAttribute::RELIGION},
+            };
+            const bool hasSelectedProvince = !m_SelectionHandler.GetProvinces().empty();
+            for(const auto& [name, attribute] : attributes) {
+                if(ImGui::MenuItem(name, nullptr, false, hasSelectedProvince)) {
+                    Bitset provinces;
+                    for(const auto& province : m_SelectionHandler.GetProvinces())
+                        provinces |= index.GetAttribute(attribute, province->GetAttributeId(attribute));
+                    m_SelectionHandler.Select(provinces);
+                }
+            }
+            ImGui::EndMenu();
+        }
+
         ImGui::EndMenu();
     }
 }
@@ -559,7 +843,7 @@ void EditorMenu::RenderModals() {
 
         bool hasSelectedTitle = (m_SelectionHandler.GetTitles().size() > 0);
         bool hasSelectedProvince = (m_SelectionHandler.GetProvinces().size() > 0);
-        bool isNameTaken = mod->GetTitles().count(name) > 0;
+        bool isNameTaken = mod->IsTitleNameTaken(name);
 
         // If there is at least one title selected then use that title upper type ass
         // the default type for the new title (capping at the empire level).
@@ -730,6 +1014,15 @@ void EditorMenu::RenderModals() {
         if(ImGui::Button("Generate", ImVec2(120, 0))) {
             ImGui::CloseCurrentPopup();
             m_App->GetMod()->GenerateMissingProvinces();
+
+            // The ids image and the provinces table sizes changed,
+            // and the map modes in memory are missing the new provinces.
+            this->UpdateTextures();
+            for(const auto& [mode, texture] : m_MapTextures) {
+                if(mode != MapMode::PROVINCES)
+                    this->UpdateTexture(mode);
+            }
+            m_SelectionHandler.Update();
         }
 
         ImGui::SetItemDefaultFocus();
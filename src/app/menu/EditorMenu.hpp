@@ -20,10 +20,20 @@ public:
     void RefreshMapMode(bool clearSelection = false, bool resetFocus = true);
     void UpdateTexture(MapMode mode, bool resetFocus = true);
     void UpdateTextures();
+    std::function<std::vector<sf::Image>()> PrepareImages(MapMode mode, bool resetFocus = true);
+    void UploadTextures(MapMode mode, std::vector<sf::Image> images);
+    void UpdateBordersTexture();
+    void SwapTextures();
+    void EvictTextures();
+
+    void InvalidateProvince(const SharedPtr<Province>& province);
+    void InvalidateTitlesColors();
+    void FlushMapUpdates();
 
     virtual void Update(sf::Time delta);
     virtual void Event(const sf::Event& event);
     virtual void Render();
+    void RenderMap();
     
     void InitSelectionCallbacks();
     void InitTabs();
@@ -41,8 +51,31 @@ private:
     sf::View m_Camera;
     sf::Clock m_Clock;
 
-    std::map<MapMode, sf::Texture> m_MapTextures;
-    sf::Sprite m_MapSprite;
+    // Map textures are split in tiles, see TiledTexture.
+    std::map<MapMode, TiledTexture> m_MapTextures;
+
+    // Images of map modes being generated in the background, the current
+    // textures are displayed until they are uploaded by EditorMenu::SwapTextures.
+    struct PendingImages {
+        SharedPtr<Task> task;
+        std::vector<sf::Image> images;
+    };
+    std::map<MapMode, SharedPtr<PendingImages>> m_PendingImages;
+
+    // Map modes of the textures in m_MapTextures from the least to the most
+    // recently shown, and the one drawn on the map which is never evicted.
+    std::list<MapMode> m_TexturesUsage;
+    MapMode m_SpriteTextureMode;
+
+    // Share the tiles of the map textures, to be sampled with the same coordinates.
+    TiledTexture m_BordersTexture;
+    TiledTexture m_ProvinceIdsTexture;
+    sf::Texture m_TitlesColorsTexture;
+
+    // Area of the map covering the provinces modified since the last frame
+    // and whether the colors of titles changed, see EditorMenu::FlushMapUpdates.
+    sf::IntRect m_OutdatedArea;
+    bool m_OutdatedTitlesColors;
 
     bool m_Dragging;
     sf::Vector2i m_LastMousePosition;
@@ -59,4 +59,18 @@ bool ImGui::CheckBoxTristate(const char* label, int* v_tristate) {
         if (ret) *v_tristate = (int)b;
     }
     return ret;
-}
\ No newline at end of file
+}
+
+bool ImGui::InputTextOnCommit(const char* label, std::string* str, const char* hint) {
+    // ImGui keeps the text being edited while the input is active,
+    // the last edit is saved to be returned when it is deactivated.
+    static std::string editedText;
+    std::string text = *str;
+    if(ImGui::InputTextWithHint(label, hint, &text))
+        editedText = text;
+
+    if(!ImGui::IsItemDeactivatedAfterEdit())
+        return false;
+    *str = editedText;
+    return true;
+}
@@ -9,4 +9,8 @@ namespace ImGui {
 
     bool ColorEdit3(const char* label, sf::Color* color, ImGuiColorEditFlags flags = 0);
     bool CheckBoxTristate(const char* label, int* v_tristate);
+
+    // Same as InputText but only return true, with the new text in str,
+    // once the input loses focus after an edit instead of on every keystroke.
+    bool InputTextOnCommit(const char* label, std::string* str, const char* hint = "");
 }
\ No newline at end of file
@@ -12,6 +12,9 @@ void SelectionHandler::Select(const SharedPtr<Province>& province) {
     if(province == nullptr || this->IsSelected(province))
         return;
     m_Provinces.push_back(province);
+    if(province->GetId() >= (int) m_SelectedProvinces.size())
+        m_SelectedProvinces.resize(province->GetId() + 1, false);
+    m_SelectedProvinces[province->GetId()] = true;
     this->Update();
 }
 
@@ -19,37 +22,57 @@ void SelectionHandler::Select(const SharedPtr<Title>& title) {
     if(title == nullptr || this->IsSelected(title))
         return;
     m_Titles.push_back(title);
+    m_SelectedTitles.insert(title);
+    this->Update();
+}
+
+// Select the provinces of a set of ids (see ProvincesIndex), updating the flags once.
+void SelectionHandler::Select(const Bitset& provinces) {
+    const SharedPtr<Mod>& mod = m_Menu->GetApp()->GetMod();
+    provinces.for_each([&](uint id) {
+        const SharedPtr<Province>& province = mod->GetProvinceById(id);
+        if(province == nullptr || this->IsSelected(province))
+            return;
+        m_Provinces.push_back(province);
+        if(id >= m_SelectedProvinces.size())
+            m_SelectedProvinces.resize(id + 1, false);
+        m_SelectedProvinces[id] = true;
+    });
     this->Update();
 }
 
 void SelectionHandler::Deselect(const SharedPtr<Province>& province) {
-    if(province == nullptr)
+    if(province == nullptr || !this->IsSelected(province))
         return;
-    m_Provinces.erase(std::remove(m_Provinces.begin(), m_Provinces.end(), province));
+    m_Provinces.erase(std::remove(m_Provinces.begin(), m_Provinces.end(), province), m_Provinces.end());
+    m_SelectedProvinces[province->GetId()] = false;
     this->Update();
 }
 
 void SelectionHandler::Deselect(const SharedPtr<Title>& title) {
-    if(title == nullptr)
+    if(title == nullptr || !this->IsSelected(title))
         return;
-    m_Titles.erase(std::remove(m_Titles.begin(), m_Titles.end(), title));
+    m_Titles.erase(std::remove(m_Titles.begin(), m_Titles.end(), title), m_Titles.end());
+    m_SelectedTitles.erase(title);
     this->Update();
 }
 
 void SelectionHandler::ClearSelection() {
     m_Provinces.clear();
     m_Titles.clear();
-    m_Colors.clear();
+    m_SelectedProvinces.clear();
+    m_SelectedTitles.clear();
 
     this->Update();
 }
 
 bool SelectionHandler::IsSelected(const SharedPtr<Province>& province) {
-    return std::find(m_Provinces.begin(), m_Provinces.end(), province) != m_Provinces.end();
+    int id = province->GetId();
+    return id >= 0 && id < (int) m_SelectedProvinces.size() && m_SelectedProvinces[id];
 }
 
 bool SelectionHandler::IsSelected(const SharedPtr<Title>& title) {
-    return std::find(m_Titles.begin(), m_Titles.end(), title) != m_Titles.end();
+    return m_SelectedTitles.count(title) > 0;
 }
 
 std::vector<SharedPtr<Province>>& SelectionHandler::GetProvinces() {
@@ -60,10 +83,6 @@ std::vector<SharedPtr<Title>>& SelectionHandler::GetTitles() {
     return m_Titles;
 }
 
-std::vector<sf::Glsl::Vec4>& SelectionHandler::GetColors() {
-    return m_Colors;
-}
-
 std::size_t SelectionHandler::GetCount() const {
     return m_Count;
 }
@@ -117,49 +136,65 @@ void SelectionHandler::OnClick(sf::Mouse::Button button, SharedPtr<Province> pro
 }
 
 void SelectionHandler::Update() {
-    this->UpdateColors();
+    this->UpdateFlags();
     this->UpdateShader();
 }
 
-void SelectionHandler::UpdateColors() {
-    m_Colors.clear();
+void SelectionHandler::UpdateFlags() {
+    const SharedPtr<Mod>& mod = m_Menu->GetApp()->GetMod();
+    const int provincesCount = mod->GetMaxProvinceId() + 1;
+
+    // One RGBA texel per province, where the red channel is set if the province is selected.
+    m_Flags.assign((provincesCount + 1) * 4, 0);
     m_Count = 0;
 
-    for(const auto& province : m_Provinces) {
-        sf::Color c = province->GetColor();
-        m_Colors.push_back(sf::Glsl::Vec4(c.r/255.f, c.g/255.f, c.b/255.f, 0.f));
-    }
-    m_Count = m_Provinces.size();
-
-    // The shader need the colors of provinces.
-    // Ttherefore, we have to loop recursively through
-    // each titles until we reach a barony tier and get the color.
-    // std::function<void(const SharedPtr<Title>&)> PushTitleProvincesColor = [&](const SharedPtr<Title>& title) {
-    //     if(title->Is(TitleType::BARONY)) {
-    //         const SharedPtr<BaronyTitle> barony = CastSharedPtr<BaronyTitle>(title);
-    //         const SharedPtr<Province>& province = m_Menu->GetApp()->GetMod()->GetProvincesByIds()[barony->GetProvinceId()];
-    //         sf::Color c = province->GetColor();
-    //         m_Colors.push_back(sf::Glsl::Vec4(c.r/255.f, c.g/255.f, c.b/255.f, c.a/255.f));
-    //         m_Count++;
-    //     }
-    //     else {
-    //         const SharedPtr<HighTitle>& highTitle = CastSharedPtr<HighTitle>(title);
-    //         for(const auto& dejureTitle : highTitle->GetDejureTitles())
-    //             PushTitleProvincesColor(dejureTitle);
-    //     }
-    // };
-    // for(const auto& title : m_Titles)
-    //     PushTitleProvincesColor(title);
-
-    for(const auto& title : m_Titles) {
-        sf::Color c = title->GetColor();
-        m_Colors.push_back(sf::Glsl::Vec4(c.r/255.f, c.g/255.f, c.b/255.f, ((int) title->GetType()) + 1.f));
-    }
-    m_Count += m_Titles.size();
+    const auto& Highlight = [&](const SharedPtr<Province>& province) {
+        int index = province->GetId() + 1;
+        if(index <= 0 || index > provincesCount || m_Flags[index*4] != 0)
+            return;
+        m_Flags[index*4] = 255;
+        m_Count++;
+    };
+
+    for(const auto& province : m_Provinces)
+        Highlight(province);
+
+    // A title highlights the provinces of its dejure baronies for which it is
+    // the focused title of its tier (i.e. that are not unwrapped to a lower tier).
+    std::function<void(const SharedPtr<Title>&, const SharedPtr<Title>&)> HighlightTitle = [&](const SharedPtr<Title>& selectedTitle, const SharedPtr<Title>& title) {
+        if(title->Is(TitleType::BARONY)) {
+            const SharedPtr<BaronyTitle> barony = CastSharedPtr<BaronyTitle>(title);
+            const SharedPtr<Province>& province = mod->GetProvinceById(barony->GetProvinceId());
+            if(province == nullptr)
+                return;
+            if(mod->GetProvinceFocusedTitle(province, selectedTitle->GetType()) == selectedTitle)
+                Highlight(province);
+        }
+        else {
+            const SharedPtr<HighTitle>& highTitle = CastSharedPtr<HighTitle>(title);
+            for(const auto& dejureTitle : highTitle->GetDejureTitles())
+                HighlightTitle(selectedTitle, dejureTitle);
+        }
+    };
+    for(const auto& title : m_Titles)
+        HighlightTitle(title, title);
 }
 
 void SelectionHandler::UpdateShader() {
+    // Lay out the provinces flags in rows of fixed width
+    // to keep the texture size within the GPU limits.
+    const uint width = Mod::PROVINCES_TABLE_WIDTH;
+    const uint texelsCount = m_Flags.size() / 4;
+    const sf::Vector2u size = sf::Vector2u(width, std::max(1u, (texelsCount + width - 1) / width));
+
+    if(m_FlagsTexture.getSize() != size)
+        m_FlagsTexture.create(size.x, size.y);
+
+    std::vector<sf::Uint8> pixels(size.x * size.y * 4, 0);
+    std::copy(m_Flags.begin(), m_Flags.end(), pixels.begin());
+    m_FlagsTexture.update(pixels.data());
+
     sf::Shader& provinceShader = Configuration::shaders.Get(Shaders::PROVINCES);
-    provinceShader.setUniformArray("selectedEntities", m_Colors.data(), m_Colors.size());
-    provinceShader.setUniform("selectedEntitiesCount", (int) m_Count);
-}
\ No newline at end of file
+    provinceShader.setUniform("selectionTexture", m_FlagsTexture);
+    provinceShader.setUniform("selectionTextureSize", sf::Vector2f(size));
+}
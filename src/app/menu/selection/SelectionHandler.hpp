@@ -6,6 +6,7 @@ public:
 
     void Select(const SharedPtr<Province>& province);
     void Select(const SharedPtr<Title>& title);
+    void Select(const Bitset& provinces);
     void Deselect(const SharedPtr<Province>& province);
     void Deselect(const SharedPtr<Title>& title);
     void ClearSelection();
@@ -15,7 +16,6 @@ public:
 
     std::vector<SharedPtr<Province>>& GetProvinces();
     std::vector<SharedPtr<Title>>& GetTitles();
-    std::vector<sf::Glsl::Vec4>& GetColors();
     std::size_t GetCount() const;
 
     void AddCallback(std::function<SelectionCallbackResult(sf::Mouse::Button, SharedPtr<Province>)> callback);
@@ -26,7 +26,7 @@ public:
     void Update();
     
 private:
-    void UpdateColors();
+    void UpdateFlags();
     void UpdateShader();
 
 private:
@@ -35,15 +35,22 @@ private:
     std::vector<SharedPtr<Province>> m_Provinces;
     std::vector<SharedPtr<Title>> m_Titles;
 
+    // Selected provinces (indexed by id) and titles for constant time lookups.
+    std::vector<bool> m_SelectedProvinces;
+    std::unordered_set<SharedPtr<Title>> m_SelectedTitles;
+
     std::vector<std::function<SelectionCallbackResult(sf::Mouse::Button, SharedPtr<Province>)>> m_ProvinceCallbacks;
     std::vector<std::function<SelectionCallbackResult(sf::Mouse::Button, SharedPtr<Province>, SharedPtr<Title>)>> m_TitleCallbacks;
 
-    // This vector is passed to the fragment shader to change
-    // color of pixels in selected provinces.
-    std::vector<sf::Glsl::Vec4> m_Colors;
+    // Whether each province is highlighted, either directly or through a
+    // selected title, indexed by province id+1 (see Mod::GetProvinceIdsImage).
+    // The flags are passed to the fragment shader as a texture, with one
+    // texel per province, to change the color of pixels in selected provinces.
+    std::vector<sf::Uint8> m_Flags;
+    sf::Texture m_FlagsTexture;
 
     // Keep track of the number of provinces that are
     // selected, especially for titles. The value is updated
-    // in UpdateColors() along side the colors.
+    // in UpdateFlags() along side the flags.
     std::size_t m_Count;
 };
\ No newline at end of file
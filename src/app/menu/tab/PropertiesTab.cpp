@@ -56,11 +56,12 @@ void PropertiesTab::RenderJointProvinces() {
     // Determine values based on selected provinces and
     // whether several provinces have different values for a property.
     const SharedPtr<Province>& firstProvince = m_Menu->GetSelectionHandler().GetProvinces().front();
+    const SharedPtr<Mod>& mod = m_Menu->GetApp()->GetMod();
 
-    std::string culture = firstProvince->GetCulture();
-    std::string religion = firstProvince->GetReligion();
-    std::string holding = firstProvince->GetHolding();
-    std::string terrain = firstProvince->GetTerrain();
+    std::string culture = mod->GetCultureNames().Get(firstProvince->GetCultureId());
+    std::string religion = mod->GetReligionNames().Get(firstProvince->GetReligionId());
+    std::string holding = mod->GetHoldingNames().Get(firstProvince->GetHoldingId());
+    std::string terrain = mod->GetTerrainNames().Get(firstProvince->GetTerrainId());
 
     int isCoastal = firstProvince->HasFlag(ProvinceFlags::COASTAL);
     int isLake = firstProvince->HasFlag(ProvinceFlags::LAKE);
@@ -71,10 +72,10 @@ void PropertiesTab::RenderJointProvinces() {
     int isImpassable = firstProvince->HasFlag(ProvinceFlags::IMPASSABLE);
 
     for (auto& province : m_Menu->GetSelectionHandler().GetProvinces()) {
-        if (province->GetCulture() != culture) culture = "*****";
-        if (province->GetReligion() != religion) religion = "*****";
-        if (province->GetHolding() != holding) holding = "*****";
-        if (province->GetTerrain() != terrain) terrain = "*****";
+        if (province->GetCultureId() != firstProvince->GetCultureId()) culture = "*****";
+        if (province->GetReligionId() != firstProvince->GetReligionId()) religion = "*****";
+        if (province->GetHoldingId() != firstProvince->GetHoldingId()) holding = "*****";
+        if (province->GetTerrainId() != firstProvince->GetTerrainId()) terrain = "*****";
         if (province->HasFlag(ProvinceFlags::COASTAL) != isCoastal) isCoastal = -1;
         if (province->HasFlag(ProvinceFlags::LAKE) != isLake) isLake = -1;
         if (province->HasFlag(ProvinceFlags::ISLAND) != isIsland) isIsland = -1;
@@ -93,11 +94,12 @@ void PropertiesTab::RenderJointProvinces() {
 
         // PROVINCE: terrain (combobox)
         if (ImGui::BeginCombo("terrain type", terrain.c_str())) {
-            for (const auto& [newTerrain, _] : m_Menu->GetApp()->GetMod()->GetTerrainTypes()) {
+            for (const auto& [newTerrain, _] : mod->GetTerrainTypes()) {
                 const bool isSelected = (terrain == newTerrain);
                 if (ImGui::Selectable(newTerrain.c_str(), isSelected)) {
                     for (auto& province : m_Menu->GetSelectionHandler().GetProvinces()) {
-                        province->SetTerrain(newTerrain);
+                        province->SetTerrainId(mod->GetTerrainNames().Intern(newTerrain));
+                        m_Menu->InvalidateProvince(province);
                     }
                 }
 
@@ -141,26 +143,29 @@ void PropertiesTab::RenderJointProvinces() {
         }
 
         // PROVINCE: culture (field)
-        if (ImGui::InputText("culture", &culture)) {
+        // The names are interned, so only once the input loses focus.
+        if (ImGui::InputTextOnCommit("culture", &culture)) {
             for (auto& province : m_Menu->GetSelectionHandler().GetProvinces()) {
-                province->SetCulture(culture);
+                province->SetCultureId(mod->GetCultureNames().Intern(culture));
+                m_Menu->InvalidateProvince(province);
             }
         }
 
         // PROVINCE: religion (field)
-        if (ImGui::InputText("religion", &religion)) {
+        if (ImGui::InputTextOnCommit("religion", &religion)) {
             for (auto& province : m_Menu->GetSelectionHandler().GetProvinces()) {
-                province->SetReligion(culture);
+                province->SetReligionId(mod->GetReligionNames().Intern(religion));
+                m_Menu->InvalidateProvince(province);
             }
         }
 
         // PROVINCE: holding type (combobox)
         if (ImGui::BeginCombo("holding", holding.c_str())) {
-            for(const auto& [newHolding, _] : m_Menu->GetApp()->GetMod()->GetHoldingTypes()) {
+            for(const auto& [newHolding, _] : mod->GetHoldingTypes()) {
                 const bool isSelected = (holding == newHolding);
                 if (ImGui::Selectable(newHolding.c_str(), isSelected)) {
                     for (auto& province : m_Menu->GetSelectionHandler().GetProvinces()) {
-                        province->SetHolding(newHolding);
+                        province->SetHoldingId(mod->GetHoldingNames().Intern(newHolding));
                     }
                 }
                 if (isSelected)
@@ -178,6 +183,12 @@ void PropertiesTab::RenderJointProvinces() {
 }
 
 void PropertiesTab::RenderProvinces() {
+    const SharedPtr<Mod>& mod = m_Menu->GetApp()->GetMod();
+
+    // The neighbors are selected after the loop, as
+    // selecting provinces modifies the iterated vector.
+    Bitset neighbors;
+
     for(auto& province : m_Menu->GetSelectionHandler().GetProvinces()) {
                 
         if(ImGui::CollapsingHeader(fmt::format("#{} ({})", province->GetId(), province->GetName()).c_str(), ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -195,20 +206,20 @@ void PropertiesTab::RenderProvinces() {
 
             // PROVINCE: color (colorpicker)
             sf::Color color = province->GetColor();
-            ImGui::BeginDisabled();
             if(ImGui::ColorEdit3("color", &color)) {
-                // TODO: error if color is already taken by another province.
-                // TODO: change pixels color in provinces.png.
-                province->SetColor(color);
+                if(m_Menu->GetApp()->GetMod()->SetProvinceColor(province, color))
+                    m_Menu->InvalidateProvince(province);
             }
-            ImGui::EndDisabled();
 
             // PROVINCE: terrain (combobox)
-            if (ImGui::BeginCombo("terrain type", province->GetTerrain().c_str())) {
-                for(const auto& [terrain, _] : m_Menu->GetApp()->GetMod()->GetTerrainTypes()) {
-                    const bool isSelected = (province->GetTerrain() == terrain);
-                    if (ImGui::Selectable(terrain.c_str(), isSelected))
-                        province->SetTerrain(terrain);
+            std::string provinceTerrain = mod->GetTerrainNames().Get(province->GetTerrainId());
+            if (ImGui::BeginCombo("terrain type", provinceTerrain.c_str())) {
+                for(const auto& [terrain, _] : mod->GetTerrainTypes()) {
+                    const bool isSelected = (provinceTerrain == terrain);
+                    if (ImGui::Selectable(terrain.c_str(), isSelected)) {
+                        province->SetTerrainId(mod->GetTerrainNames().Intern(terrain));
+                        m_Menu->InvalidateProvince(province);
+                    }
 
                     // Set the initial focus when opening the combo (scrolling + keyboard navigation focus)
                     if (isSelected)
@@ -253,17 +264,30 @@ void PropertiesTab::RenderProvinces() {
             }
 
             // PROVINCE: culture (field)
-            ImGui::InputText("culture", &province->m_Culture);
+            // The culture and religion inherited from the county are shown as hints.
+            InheritedAttributes& inheritedAttributes = mod->GetInheritedAttributes();
+            std::string culture = mod->GetCultureNames().Get(province->GetCultureId());
+            std::string inheritedCulture = mod->GetCultureNames().Get(inheritedAttributes.GetAttributeId(ProvinceAttribute::CULTURE, province->GetId()));
+            if(ImGui::InputTextOnCommit("culture", &culture, inheritedCulture.c_str())) {
+                province->SetCultureId(mod->GetCultureNames().Intern(culture));
+                m_Menu->InvalidateProvince(province);
+            }
 
             // PROVINCE: religion (field)
-            ImGui::InputText("religion", &province->m_Religion);
+            std::string religion = mod->GetReligionNames().Get(province->GetReligionId());
+            std::string inheritedReligion = mod->GetReligionNames().Get(inheritedAttributes.GetAttributeId(ProvinceAttribute::RELIGION, province->GetId()));
+            if(ImGui::InputTextOnCommit("religion", &religion, inheritedReligion.c_str())) {
+                province->SetReligionId(mod->GetReligionNames().Intern(religion));
+                m_Menu->InvalidateProvince(province);
+            }
 
             // PROVINCE: holding type (combobox)
-            if (ImGui::BeginCombo("holding", province->GetHolding().c_str())) {
-                for(const auto& [holding, _] : m_Menu->GetApp()->GetMod()->GetHoldingTypes()) {
-                    const bool isSelected = (province->GetHolding() == holding);
+            std::string provinceHolding = mod->GetHoldingNames().Get(province->GetHoldingId());
+            if (ImGui::BeginCombo("holding", provinceHolding.c_str())) {
+                for(const auto& [holding, _] : mod->GetHoldingTypes()) {
+                    const bool isSelected = (provinceHolding == holding);
                     if (ImGui::Selectable(holding.c_str(), isSelected))
-                        province->SetHolding(holding);
+                        province->SetHoldingId(mod->GetHoldingNames().Intern(holding));
                     if (isSelected)
                         ImGui::SetItemDefaultFocus();
                 }
@@ -282,12 +306,7 @@ void PropertiesTab::RenderProvinces() {
             else if(province->HasFlag(ProvinceFlags::LAND) && !province->HasFlag(ProvinceFlags::IMPASSABLE)) {
                 if(ImGui::Button("create barony title")) {
                     // Make sure to use a title name that isn't already taken.
-                    std::string baronyName = "b_" + String::ToLowercase(province->GetName());
-                    int i = 1;
-                    while(m_Menu->GetApp()->GetMod()->GetTitles().count(baronyName) > 0) {
-                        baronyName = "b_" + String::ToLowercase(province->GetName()) + std::to_string(i);
-                        i++;
-                    }
+                    std::string baronyName = m_Menu->GetApp()->GetMod()->GetAvailableTitleName("b_" + String::ToLowercase(province->GetName()));
 
                     SharedPtr<Title> title = MakeTitle(TitleType::BARONY, baronyName, province->GetColor(), false);
                     SharedPtr<BaronyTitle> baronyTitle = CastSharedPtr<BaronyTitle>(title);
@@ -297,10 +316,19 @@ void PropertiesTab::RenderProvinces() {
                 }
             }
 
+            // PROVINCE: select neighbors (button)
+            if(ImGui::Button("select neighbors")) {
+                for(int neighborId : mod->GetProvinceNeighbors(province->GetId()))
+                    neighbors.set(neighborId);
+            }
+
             ImGui::PopID();
             ImGui::EndChild();
         }
     }
+
+    if(!neighbors.empty())
+        m_Menu->GetSelectionHandler().Select(neighbors);
 }
 
 // Because the user inputs are strings for the history data,
@@ -322,20 +350,34 @@ void PropertiesTab::RenderTitles() {
             ImGui::PushID(title->GetName().c_str());
 
             // TITLE: name/tag (field)
-            std::string formerName = title->m_Name;
-            if(ImGui::InputText("name", &title->m_Name)) {
+            // The title is renamed once the input loses focus, and
+            // keeps its former name if the new one is already used.
+            std::string name = title->GetName();
+            if(ImGui::InputTextOnCommit("name", &name) && name != title->GetName()) {
+                std::string formerName = title->GetName();
+                title->m_Name = name;
                 // Rename the title globally, including titles history.
-                m_Menu->GetApp()->GetMod()->RenameTitle(title, formerName);
+                if(!m_Menu->GetApp()->GetMod()->RenameTitle(title, formerName))
+                    title->m_Name = formerName;
             }
             
             // TITLE: localization name (field)
-            ImGui::InputText("loc. name", &title->GetLocName("english"));
+            // The localization is interned, edit a copy and set it back once
+            // the input loses focus so that each keystroke isn't interned.
+            StringPool& localization = m_Menu->GetApp()->GetMod()->GetLocalizationStrings();
+            std::string locName = title->GetLocName(localization, "english");
+            if(ImGui::InputTextOnCommit("loc. name", &locName))
+                title->SetLocName(localization, "english", locName);
             
             // TITLE: localization adjective (field)
-            ImGui::InputText("loc. adjective", &title->GetLocAdjective("english"));
+            std::string locAdjective = title->GetLocAdjective(localization, "english");
+            if(ImGui::InputTextOnCommit("loc. adjective", &locAdjective))
+                title->SetLocAdjective(localization, "english", locAdjective);
             
             // TITLE: localization article (field)
-            ImGui::InputText("loc. article", &title->GetLocArticle("english"));
+            std::string locArticle = title->GetLocArticle(localization, "english");
+            if(ImGui::InputTextOnCommit("loc. article", &locArticle))
+                title->SetLocArticle(localization, "english", locArticle);
 
             // TITLE: tier/type (combo)
             ImGui::BeginDisabled();
@@ -347,8 +389,7 @@ void PropertiesTab::RenderTitles() {
             sf::Color color = title->GetColor();
             if(ImGui::ColorEdit3("color", &color)) {
                 title->SetColor(color);
-                m_Menu->RefreshMapMode(false);
-                m_Menu->GetSelectionHandler().Update();
+                m_Menu->InvalidateTitlesColors();
             }
 
             // TITLE: landless (checkbox)
@@ -377,19 +418,17 @@ void PropertiesTab::RenderTitles() {
                         AddNewCulture();
                     }
 
-                    std::map<std::string, std::string>& culturalNames = title->GetCulturalNames();
-                    for(auto it = culturalNames.begin(); it != culturalNames.end(); ) {
-                        std::string culture = it->first;
-                        std::string& name = it->second;
-                        if(ImGui::Button("x")) {
-                            it = culturalNames.erase(it);
-                        }
-                        else {
-                            ++it;
-                        }
+                    // Remove through the title once the names are displayed,
+                    // to keep its references up to date and the entries in place.
+                    std::string removedCulture;
+                    for(auto& [culture, name] : title->GetCulturalNames()) {
+                        if(ImGui::Button("x"))
+                            removedCulture = culture;
                         ImGui::SameLine();
                         ImGui::InputText(culture.c_str(), &name);
                     }
+                    if(!removedCulture.empty())
+                        title->RemoveCulturalName(removedCulture);
                 }
                 ImGui::EndChild();
             }
@@ -473,12 +512,32 @@ void PropertiesTab::RenderTitles() {
                 ImGui::EndChild();
             }
 
+            // TITLE: references (collapsing header listing the titles referencing this one)
+            ImGui::SetNextItemOpen(false, ImGuiCond_Once);
+            if(ImGui::CollapsingHeader("references")) {
+                const TitleReferences& references = m_Menu->GetApp()->GetMod()->GetTitlesHierarchy().GetReferences();
+                const std::set<TitleReference>& titleReferences = references.Get(title->GetName());
+                if(titleReferences.empty())
+                    ImGui::TextDisabled("No references");
+
+                for(const TitleReference& reference : titleReferences) {
+                    std::string label = reference.title->GetName();
+                    switch(reference.type) {
+                        case ReferenceType::LIEGE: label += fmt::format(": liege at {}", reference.date); break;
+                        case ReferenceType::DE_JURE_LIEGE: label += fmt::format(": de jure liege at {}", reference.date); break;
+                        case ReferenceType::CAPITAL: label += ": capital"; break;
+                        default: break;
+                    }
+                    ImGui::BulletText("%s", label.c_str());
+                }
+            }
+
             if(title->Is(TitleType::BARONY)) {
 
                 // BARONY: province id (field)
                 const SharedPtr<BaronyTitle>& barony = CastSharedPtr<BaronyTitle>(title);
                 if(ImGui::InputInt("province id", &barony->m_ProvinceId)) {
-                    if(m_Menu->GetApp()->GetMod()->GetProvincesByIds().count(barony->m_ProvinceId) == 0) {
+                    if(m_Menu->GetApp()->GetMod()->GetProvinceById(barony->m_ProvinceId) == nullptr) {
                         LOG_ERROR("Barony with undefined province id: {},{}", barony->GetName(), barony->GetProvinceId());
                     }
                 }
@@ -506,8 +565,8 @@ void PropertiesTab::RenderTitles() {
 
                 // BARONY: Switch to province (button)
                 if(ImGui::Button("switch to province")) {
-                    if(m_Menu->GetApp()->GetMod()->GetProvincesByIds().count(barony->GetProvinceId()) > 0) {
-                        const SharedPtr<Province>& province = m_Menu->GetApp()->GetMod()->GetProvincesByIds()[barony->GetProvinceId()];
+                    const SharedPtr<Province>& province = m_Menu->GetApp()->GetMod()->GetProvinceById(barony->GetProvinceId());
+                    if(province != nullptr) {
                         m_Menu->SwitchMapMode(MapMode::PROVINCES, true);
                         m_Menu->GetSelectionHandler().Select(province);
                     }
@@ -584,6 +643,7 @@ void PropertiesTab::RenderTitles() {
                                     return SelectionCallbackResult::INTERRUPT;
                                 highTitle->AddDejureTitle(clickedTitle);
                                 m_Menu->SwitchMapMode(TitleTypeToMapMode(highTitle->GetType()), false);
+                                m_Menu->RefreshMapMode();
                                 m_SelectingTitle = false;
                                 return SelectionCallbackResult::INTERRUPT | SelectionCallbackResult::DELETE_CALLBACK;
                             }
@@ -21,7 +21,7 @@ void ProvincesTab::Render() {
     if(ImGui::InputText("filter", &filter)) {
         filteredProvinces.clear();
 
-        for(const auto& [colorId, province] : mod->GetProvinces()) {
+        for(const auto& province : mod->GetProvinces()) {
             filteredProvinces[province->GetName()] = (province->GetName().find(filter) != std::string::npos);
         }
     }
@@ -32,7 +32,7 @@ void ProvincesTab::Render() {
         ImGui::TableSetupColumn("Color", ImGuiTableColumnFlags_WidthFixed, 100.0f);
         ImGui::TableHeadersRow();
 
-        for(const auto& [colorId, province] : mod->GetProvinces()) {
+        for(const auto& province : mod->GetProvinces()) {
             if(filteredProvinces.count(province->GetName()) > 0 && !filteredProvinces[province->GetName()])
                 continue;
 
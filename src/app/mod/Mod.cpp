@@ -10,154 +10,189 @@
 #include <fmt/ostream.h>
 
 Mod::Mod(const std::string& dir)
-: m_Dir(dir), m_TitlesLocalizationFilePath(dir + "/localization/english/00_titles_l_english.yml")
+: m_Dir(dir), m_ProvinceIdsImage(MakeShared<sf::Image>()), m_ProvinceImageModified(false), m_ErasedTitlesByType(0), m_InheritedAttributes(m_ProvincesIndex, m_TitlesHierarchy, m_BaroniesByProvinceIds), m_BorderMaskStride(0), m_BorderMaskUpdatedArea(0, 0, 0, 0), m_BorderMaskPendingArea(0, 0, 0, 0), m_BorderMaskGeneration(0), m_BorderMaskTaskGeneration(0), m_HoldingNames("none"), m_TitlesLocalizationFilePath(dir + "/localization/english/00_titles_l_english.yml")
 {}
 
+Mod::~Mod() {
+    // Provinces may outlive the mod, detach them from its index.
+    for(const auto& province : m_Provinces)
+        m_ProvincesIndex.Remove(*province);
+}
+
 std::string Mod::GetDir() const {
     return m_Dir;
 }
 
-sf::Image& Mod::GetHeightmapImage() {
-    return m_HeightmapImage;
+sf::Vector2u Mod::GetHeightmapSize() const {
+    return m_HeightmapSize;
 }
 
-sf::Image& Mod::GetProvinceImage() {
-    return m_ProvinceImage;
+const std::vector<sf::Uint8>& Mod::GetHeightmap() const {
+    return m_Heightmap;
 }
 
-sf::Image& Mod::GetRiversImage() {
-    return m_RiversImage;
+sf::Image Mod::GetHeightmapImage() const {
+    return Image::FromGrayscale(m_HeightmapSize, m_Heightmap);
 }
 
-sf::Image Mod::GetTerrainImage() {
-    // - Map provinces colors to their terrain color.
-    // - Copy province image.
-    // - Replace province pixels by their mapped color.
-    sf::Color defaultColor = sf::Color(0, 0, 0);
+sf::Image& Mod::GetProvinceImage() {
+    return m_ProvinceImage;
+}
 
-    sf::Image image = Image::MapPixels(m_ProvinceImage, [&](auto& mappedColors){
-        for(const auto& [provinceColorId, province] : m_Provinces) {
-            std::string terrain = province->GetTerrain();
-            sf::Color color = defaultColor;
+const std::vector<sf::Uint8>& Mod::GetRivers() const {
+    return m_Rivers;
+}
 
-            if(m_TerrainTypes.contains(terrain)) {
-                TerrainType terrainType = m_TerrainTypes.at(terrain);
-                color = terrainType.GetColor();
-            }
+const std::vector<sf::Uint32>& Mod::GetRiversPalette() const {
+    return m_RiversPalette;
+}
 
-            mappedColors[province->GetColor().toInteger()] = color.toInteger();
-        }    
-    });
-    return image;
+sf::Image Mod::GetRiversImage() const {
+    return Image::FromIndexed(m_RiversSize, m_Rivers, m_RiversPalette);
 }
 
-sf::Image Mod::GetCultureImage() {
-    // - Map provinces colors to their culture color (province -> county -> county capital -> province).
-    // - Copy province image.
-    // - Replace province pixels by their mapped color.
-    // - Provinces with an explicit culture assigned will have alpha=0
-    //   in order to inform the shader.
-    sf::Color defaultColor = sf::Color(127, 127, 127);
+sf::Image& Mod::GetProvinceIdsImage() {
+    return *m_ProvinceIdsImage;
+}
 
-    sf::Image image = Image::MapPixels(m_ProvinceImage, [&](auto& mappedColors){
-        for(const auto& [provinceColorId, province] : m_Provinces) {
-            std::string cultureName = province->GetCulture();
-            sf::Color color = defaultColor;
-            sf::Uint8 alpha = cultureName.empty() ? 255 : 0;
+SharedPtr<const sf::Image> Mod::GetSharedProvinceIdsImage() const {
+    return m_ProvinceIdsImage;
+}
 
-            if(cultureName.empty()) {
-                const SharedPtr<CountyTitle>& liege = CastSharedPtr<CountyTitle>(this->GetProvinceLiegeTitle(province, TitleType::COUNTY));
+sf::IntRect Mod::GetImageArea(sf::IntRect area) const {
+    // Clamp an area to the bounds of the map, which is the whole map if the area is empty.
+    sf::IntRect bounds = sf::IntRect(0, 0, m_ProvinceImage.getSize().x, m_ProvinceImage.getSize().y);
+    if(area.width <= 0 || area.height <= 0)
+        return bounds;
+
+    int left = std::max(area.left, bounds.left);
+    int top = std::max(area.top, bounds.top);
+    int right = std::min(area.left + area.width, bounds.width);
+    int bottom = std::min(area.top + area.height, bounds.height);
+    return sf::IntRect(left, top, std::max(0, right - left), std::max(0, bottom - top));
+}
 
-                if(liege == nullptr) {
-                    goto End;
-                }
+std::vector<sf::Uint32> Mod::GetTerrainColors() {
+    // - Map provinces to their terrain color, indexed like the province ids image (id+1).
+    // - The color of each terrain is only looked up once, in a palette indexed by terrain id.
+    std::vector<sf::Uint32> palette(m_TerrainNames.GetCount(), sf::Color(0, 0, 0).toInteger());
+    for(uint id = 0; id < palette.size(); id++) {
+        const std::string& terrain = m_TerrainNames.Get(id);
+        if(m_TerrainTypes.contains(terrain))
+            palette[id] = m_TerrainTypes.at(terrain).GetColor().toInteger();
+    }
 
-                for(const auto& dejureTitle : liege->GetDejureTitles()) {
-                    const SharedPtr<BaronyTitle>& barony = CastSharedPtr<BaronyTitle>(dejureTitle);
-                    const SharedPtr<Province>& baronyProvince = m_ProvincesByIds[barony->GetProvinceId()];
+    // The provinces are read from the column of the index rather than their objects,
+    // the ids without province are never looked up as no pixel has them.
+    const std::vector<uint>& terrains = m_ProvincesIndex.GetAttributeColumn(ProvinceAttribute::TERRAIN);
 
-                    if(baronyProvince != nullptr && !baronyProvince->GetCulture().empty()) {
-                        cultureName = baronyProvince->GetCulture();
-                        break;
-                    }
-                }
-            }
+    std::vector<sf::Uint32> mappedColors(terrains.size() + 1, sf::Color(0, 0, 0).toInteger());
+    for(uint id = 0; id < terrains.size(); id++)
+        mappedColors[id + 1] = palette[terrains[id]];
+    return mappedColors;
+}
 
-            if(cultureName.empty() || m_Cultures.count(cultureName) == 0) {
-                color = sf::Color(cultureName[0], cultureName[1], cultureName[2]);
-            } 
-            else {
-                SharedPtr<Culture> culture = m_Cultures[cultureName];
-                color = culture->GetColor();
-            }
+sf::Image Mod::GetTerrainImage(sf::IntRect area) {
+    // Map the area of the province ids image to the colors of the provinces.
+    return Image::MapIds(*m_ProvinceIdsImage, this->GetImageArea(area), this->GetTerrainColors());
+}
 
-            End:
-            color.a = alpha;
-            mappedColors[province->GetColor().toInteger()] = color.toInteger();
-        }    
-    });
-    return image;
+static sf::Color GetNameColor(const std::string& name) {
+    // Color of the cultures and religions that are not defined, from the first letters of their name.
+    const auto& GetChar = [&](uint i) { return (sf::Uint8) (i < name.size() ? name[i] : 0); };
+    return sf::Color(GetChar(0), GetChar(1), GetChar(2));
 }
 
-sf::Image Mod::GetReligionImage() {
-    // - Map provinces colors to their religion color (province -> county -> county capital -> province).
-    // - Copy province image.
-    // - Replace province pixels by their mapped color.
-    // - Provinces with an explicit religion assigned will have alpha=0
+std::vector<sf::Uint32> Mod::GetCultureColors() {
+    // - Map provinces to their culture color, indexed like the province ids image (id+1) (province -> county -> county capital -> province),
+    //   which is resolved by the cache of inherited attributes.
+    // - Provinces with an explicit culture assigned will have alpha=0
     //   in order to inform the shader.
+    // - The color of each culture is only looked up once, in a palette indexed by culture id.
     sf::Color defaultColor = sf::Color(127, 127, 127);
 
-    sf::Image image = Image::MapPixels(m_ProvinceImage, [&](auto& mappedColors){
-        for(const auto& [provinceColorId, province] : m_Provinces) {
-            std::string religionName = province->GetReligion();
-            sf::Color color = defaultColor;
-            sf::Uint8 alpha = religionName.empty() ? 255 : 0;
+    std::vector<sf::Color> palette(m_CultureNames.GetCount());
+    for(uint id = 0; id < palette.size(); id++) {
+        const std::string& name = m_CultureNames.Get(id);
+        palette[id] = (m_Cultures.count(name) == 0) ? GetNameColor(name) : m_Cultures[name]->GetColor();
+    }
 
-            if(religionName.empty()) {
-                const SharedPtr<CountyTitle>& liege = CastSharedPtr<CountyTitle>(this->GetProvinceLiegeTitle(province, TitleType::COUNTY));
+    // The provinces are read from the columns of the index rather than their objects.
+    const std::vector<uint>& cultures = m_ProvincesIndex.GetAttributeColumn(ProvinceAttribute::CULTURE);
 
-                if(liege == nullptr) {
-                    goto End;
-                }
+    std::vector<sf::Uint32> mappedColors(cultures.size() + 1, sf::Color(0, 0, 0).toInteger());
+    m_ProvincesIndex.GetProvinces().for_each([&](uint id) {
+        uint culture = m_InheritedAttributes.GetAttributeId(ProvinceAttribute::CULTURE, id);
+        sf::Color color = (culture == 0) ? defaultColor : palette[culture];
+        color.a = (cultures[id] == 0) ? 255 : 0;
+        mappedColors[id + 1] = color.toInteger();
+    });
+    return mappedColors;
+}
+
+sf::Image Mod::GetCultureImage(sf::IntRect area) {
+    // Map the area of the province ids image to the colors of the provinces.
+    return Image::MapIds(*m_ProvinceIdsImage, this->GetImageArea(area), this->GetCultureColors());
+}
 
-                for(const auto& dejureTitle : liege->GetDejureTitles()) {
-                    const SharedPtr<BaronyTitle>& barony = CastSharedPtr<BaronyTitle>(dejureTitle);
-                    const SharedPtr<Province>& baronyProvince = m_ProvincesByIds[barony->GetProvinceId()];
+std::vector<sf::Uint32> Mod::GetReligionColors() {
+    // - Map provinces to their religion color, indexed like the province ids image (id+1) (province -> county -> county capital -> province),
+    //   which is resolved by the cache of inherited attributes.
+    // - Provinces with an explicit religion assigned will have alpha=0
+    //   in order to inform the shader.
+    // - The color of each religion is only looked up once, in a palette indexed by religion id.
+    sf::Color defaultColor = sf::Color(127, 127, 127);
 
-                    if(baronyProvince != nullptr && !baronyProvince->GetReligion().empty()) {
-                        religionName = baronyProvince->GetReligion();
-                        break;
-                    }
-                }
-            }
+    std::vector<sf::Color> palette(m_ReligionNames.GetCount());
+    for(uint id = 0; id < palette.size(); id++) {
+        const std::string& name = m_ReligionNames.Get(id);
+        palette[id] = (m_Religions.count(name) == 0) ? GetNameColor(name) : m_Religions[name]->GetColor();
+    }
 
-            if(m_Religions.count(religionName) == 0 || m_Religions.count(religionName) == 0) {
-                color = sf::Color(religionName[0], religionName[1], religionName[2]);
-            } 
-            else {
-                SharedPtr<Religion> religion = m_Religions[religionName];
-                color = religion->GetColor();
-            }
+    // The provinces are read from the columns of the index rather than their objects.
+    const std::vector<uint>& religions = m_ProvincesIndex.GetAttributeColumn(ProvinceAttribute::RELIGION);
 
-            End:
-            color.a = alpha;
-            mappedColors[province->GetColor().toInteger()] = color.toInteger();
-        }    
+    std::vector<sf::Uint32> mappedColors(religions.size() + 1, sf::Color(0, 0, 0).toInteger());
+    m_ProvincesIndex.GetProvinces().for_each([&](uint id) {
+        uint religion = m_InheritedAttributes.GetAttributeId(ProvinceAttribute::RELIGION, id);
+        sf::Color color = (religion == 0) ? defaultColor : palette[religion];
+        color.a = (religions[id] == 0) ? 255 : 0;
+        mappedColors[id + 1] = color.toInteger();
     });
-    return image;
+    return mappedColors;
+}
+
+sf::Image Mod::GetReligionImage(sf::IntRect area) {
+    // Map the area of the province ids image to the colors of the provinces.
+    return Image::MapIds(*m_ProvinceIdsImage, this->GetImageArea(area), this->GetReligionColors());
 }
 
-sf::Image Mod::GetTitleImage(TitleType type) {
-    sf::Image image = Image::MapPixels(m_ProvinceImage, [&](auto& mappedColors){
-        for(const auto& [provinceColorId, province] : m_Provinces) {
-            const SharedPtr<Title>& liege = this->GetProvinceFocusedTitle(province, type);
+sf::Image Mod::GetTitlesColorsImage() {
+    // Table of the color of the focused title of each tier for every province,
+    // indexed like the province ids image (id+1, see Mod::UpdateProvinceIdsImage).
+    // The indices are laid out in rows of PROVINCES_TABLE_WIDTH texels and
+    // the tiers are stacked vertically, one block of rows per tier.
+    // Provinces without barony keep their own color.
+    const uint width = PROVINCES_TABLE_WIDTH;
+    const uint indicesCount = this->GetMaxProvinceId() + 2;
+    const uint rowsCount = std::max(1u, (indicesCount + width - 1) / width);
+
+    sf::Image image;
+    image.create(width, rowsCount * (int) TitleType::COUNT, sf::Color::Transparent);
+
+    for(const auto& province : m_Provinces) {
+        if(province->GetId() < 0)
+            continue;
 
-            if(liege == nullptr)
-                continue;
+        const uint index = province->GetId() + 1;
+        const bool hasTitles = province->GetId() < (int) m_ProvincesFocusedTitles.size()
+            && m_ProvincesFocusedTitles[province->GetId()][(int) TitleType::BARONY] != nullptr;
 
-            mappedColors[province->GetColor().toInteger()] = liege->GetColor().toInteger();
-        }    
-    });
+        for(int type = 0; type < (int) TitleType::COUNT; type++) {
+            sf::Color color = hasTitles ? m_ProvincesFocusedTitles[province->GetId()][type]->GetColor() : province->GetColor();
+            image.setPixel(index % width, type * rowsCount + index / width, color);
+        }
+    }
     return image;
 }
 
@@ -165,58 +200,487 @@ bool Mod::HasMap() const {
     return std::filesystem::exists(m_Dir + "/map_data/provinces.png");
 }
 
-std::map<uint32_t, SharedPtr<Province>>& Mod::GetProvinces() {
+const std::vector<SharedPtr<Province>>& Mod::GetProvinces() const {
     return m_Provinces;
 }
 
-std::map<int, SharedPtr<Province>>& Mod::GetProvincesByIds() {
-    return m_ProvincesByIds;
+const SharedPtr<Province>& Mod::GetProvinceById(int id) const {
+    static const SharedPtr<Province> none = nullptr;
+    if(id < 0 || id >= (int) m_ProvincesIndices.size() || m_ProvincesIndices[id] < 0)
+        return none;
+    return m_Provinces[m_ProvincesIndices[id]];
 }
 
-SharedPtr<Title> Mod::GetProvinceLiegeTitle(const SharedPtr<Province>& province, TitleType type) {
-    if(m_BaroniesByProvinceIds.count(province->GetId()) == 0)
+const SharedPtr<Province>& Mod::GetProvinceByColor(sf::Uint32 colorId) const {
+    static const SharedPtr<Province> none = nullptr;
+    const int* id = m_ProvincesIds.find(colorId);
+    return (id == nullptr) ? none : this->GetProvinceById(*id);
+}
+
+const ProvincesIndex& Mod::GetProvincesIndex() const {
+    return m_ProvincesIndex;
+}
+
+SharedPtr<Province> Mod::GetProvinceAt(sf::Vector2i position) const {
+    const sf::Vector2u size = m_ProvinceIdsImage->getSize();
+    if(position.x < 0 || position.y < 0 || position.x >= (int) size.x || position.y >= (int) size.y)
         return nullptr;
 
-    const SharedPtr<Title>& barony = m_BaroniesByProvinceIds[province->GetId()];
+    // The ids image stores id+1 of the province of each pixel, 0 if there is none.
+    const sf::Uint8* pixel = m_ProvinceIdsImage->getPixelsPtr() + (position.y * size.x + position.x) * 4;
+    const int index = (pixel[0] << 16) | (pixel[1] << 8) | pixel[2];
+    return this->GetProvinceById(index - 1);
+}
+
+void Mod::AddProvince(const SharedPtr<Province>& province) {
+    // Keep the provinces sorted by id, which are almost always added in increasing order.
+    // A province with the same id as another one replaces it.
+    const int id = province->GetId();
+    if(id < 0) {
+        LOG_ERROR("Invalid province id: {}", id);
+        return;
+    }
 
-    #define RETURN_IF_NULL(v) if(v == nullptr) return nullptr;
+    if(id >= (int) m_ProvincesIndices.size())
+        m_ProvincesIndices.resize(id + 1, -1);
 
-    // Determine which liege title to choose depending on type.
-    switch(type) {
-        case TitleType::BARONY:  return barony;
-        case TitleType::COUNTY:  return barony->GetLiegeTitle();
-        case TitleType::DUCHY:
-            RETURN_IF_NULL(barony->GetLiegeTitle());
-            return barony->GetLiegeTitle()->GetLiegeTitle();
-        case TitleType::KINGDOM:
-            RETURN_IF_NULL(barony->GetLiegeTitle());
-            RETURN_IF_NULL(barony->GetLiegeTitle()->GetLiegeTitle());
-            return barony->GetLiegeTitle()->GetLiegeTitle()->GetLiegeTitle();
-        case TitleType::EMPIRE:
-            RETURN_IF_NULL(barony->GetLiegeTitle());
-            RETURN_IF_NULL(barony->GetLiegeTitle()->GetLiegeTitle());
-            RETURN_IF_NULL(barony->GetLiegeTitle()->GetLiegeTitle()->GetLiegeTitle());
-            return barony->GetLiegeTitle()->GetLiegeTitle()->GetLiegeTitle()->GetLiegeTitle();
-        default: return nullptr;
+    if(m_ProvincesIndices[id] >= 0) {
+        SharedPtr<Province>& previousProvince = m_Provinces[m_ProvincesIndices[id]];
+        m_ProvincesIds.erase(previousProvince->GetColorId());
+        m_ProvincesIndex.Remove(*previousProvince);
+        previousProvince = province;
     }
+    else {
+        const auto& it = std::upper_bound(m_Provinces.begin(), m_Provinces.end(), id, [](int id, const SharedPtr<Province>& other) {
+            return id < other->GetId();
+        });
+        uint index = m_Provinces.insert(it, province) - m_Provinces.begin();
+        for(; index < m_Provinces.size(); index++)
+            m_ProvincesIndices[m_Provinces[index]->GetId()] = index;
+    }
+    m_ProvincesIds.insert(province->GetColorId(), id);
+    m_ProvincesIndex.Add(*province);
+}
+
+SharedPtr<Title> Mod::GetProvinceLiegeTitle(const SharedPtr<Province>& province, TitleType type) {
+    const auto& it = m_BaroniesByProvinceIds.find(province->GetId());
+    if(it == m_BaroniesByProvinceIds.end())
+        return nullptr;
+    return m_TitlesHierarchy.GetAncestor(it->second->GetId(), type);
 }
 
 SharedPtr<Title> Mod::GetProvinceFocusedTitle(const SharedPtr<Province>& province, TitleType type) {
-    if(m_BaroniesByProvinceIds.count(province->GetId()) == 0)
+    // The focused titles are cached for every tier when the selection
+    // focus changes (see Mod::UpdateProvinceFocusedTitles).
+    const int provinceId = province->GetId();
+    if(provinceId < 0 || provinceId >= (int) m_ProvincesFocusedTitles.size() || (int) type >= (int) TitleType::COUNT)
         return nullptr;
+    return m_ProvincesFocusedTitles[provinceId][(int) type];
+}
+
+void Mod::UpdateProvincesFocusedTitles() {
+    m_ProvincesFocusedTitles.clear();
+    m_ProvincesFocusedTitles.resize(this->GetMaxProvinceId() + 1);
+
+    for(const auto& [provinceId, barony] : m_BaroniesByProvinceIds)
+        this->UpdateProvinceFocusedTitles(barony);
+
+    this->UpdateBorderMaskAsync();
+}
+
+void Mod::UpdateProvincesFocusedTitles(const SharedPtr<Title>& title) {
+    // Only the provinces of the dejure baronies of the title can
+    // be affected by a change of its selection focus, so the border
+    // mask only needs to be updated around them.
+    sf::IntRect area = sf::IntRect(0, 0, 0, 0);
+
+    std::function<void(const SharedPtr<Title>&)> UpdateTitle = [&](const SharedPtr<Title>& title) {
+        if(!title->Is(TitleType::BARONY)) {
+            for(const auto& dejureTitle : StaticCastSharedPtr<HighTitle>(title)->GetDejureTitles())
+                UpdateTitle(dejureTitle);
+            return;
+        }
+
+        const SharedPtr<BaronyTitle>& barony = StaticCastSharedPtr<BaronyTitle>(title);
+        this->UpdateProvinceFocusedTitles(barony);
+
+        const SharedPtr<Province>& province = this->GetProvinceById(barony->GetProvinceId());
+        if(province == nullptr || province->GetImagePixelsCount() == 0)
+            return;
+
+        area = Math::UnionRect(area, province->GetImageBoundingBox());
+    };
+    UpdateTitle(title);
+
+    if(area.width == 0 || area.height == 0)
+        return;
+
+    // The pixels around the provinces share a border with them.
+    int left = std::max(0, area.left - 1);
+    int top = std::max(0, area.top - 1);
+    int right = std::min((int) m_ProvinceImage.getSize().x, area.left + area.width + 1);
+    int bottom = std::min((int) m_ProvinceImage.getSize().y, area.top + area.height + 1);
+    this->UpdateBorderMask(sf::IntRect(left, top, right - left, bottom - top));
+}
+
+void Mod::UpdateProvinceFocusedTitles(const SharedPtr<BaronyTitle>& barony) {
+    int provinceId = barony->GetProvinceId();
+    if(provinceId < 0 || provinceId >= (int) m_ProvincesFocusedTitles.size())
+        return;
+    if(m_BaroniesByProvinceIds.count(provinceId) == 0 || m_BaroniesByProvinceIds[provinceId] != barony)
+        return;
+
+    // Walk up the liege chain once for all tiers, stopping at the first unfocused liege.
+    auto& titles = m_ProvincesFocusedTitles[provinceId];
+    SharedPtr<Title> focusedTitle = barony;
+
+    for(int type = 0; type < (int) TitleType::COUNT; type++) {
+        while(focusedTitle->GetLiegeTitle() != nullptr && (int) focusedTitle->GetType() < type && focusedTitle->GetLiegeTitle()->HasSelectionFocus()) {
+            focusedTitle = focusedTitle->GetLiegeTitle();
+        }
+        titles[type] = focusedTitle;
+    }
+}
+
+const std::vector<sf::Uint8>& Mod::GetBorderMask() const {
+    return m_BorderMask;
+}
+
+uint Mod::GetBorderMaskStride() const {
+    return m_BorderMaskStride;
+}
 
-    SharedPtr<Title> barony = m_BaroniesByProvinceIds[province->GetId()];
-    SharedPtr<Title> title = barony;
+sf::IntRect Mod::FlushBorderMaskUpdates() {
+    // Swap in the border mask generated in the background once it is done. The
+    // areas updated in the meantime are computed again on top of it since they
+    // were only applied to the previous mask. If the whole mask was outdated
+    // while it was generated, drop it and generate the latest one instead.
+    if(m_BorderMaskTask != nullptr && m_BorderMaskTask->IsDone()) {
+        m_BorderMaskTask = nullptr;
+        SharedPtr<std::vector<sf::Uint8>> backBuffer = m_BorderMaskBackBuffer;
+        m_BorderMaskBackBuffer = nullptr;
+
+        if(m_BorderMaskTaskGeneration != m_BorderMaskGeneration) {
+            this->SubmitBorderMaskTask();
+        }
+        else {
+            m_BorderMask.swap(*backBuffer);
+
+            sf::IntRect pendingArea = m_BorderMaskPendingArea;
+            m_BorderMaskPendingArea = sf::IntRect(0, 0, 0, 0);
+            if(pendingArea.width > 0 && pendingArea.height > 0)
+                this->UpdateBorderMask(pendingArea);
+
+            m_BorderMaskUpdatedArea = sf::IntRect(0, 0, m_ProvinceImage.getSize().x, m_ProvinceImage.getSize().y);
+        }
+    }
+
+    sf::IntRect area = m_BorderMaskUpdatedArea;
+    m_BorderMaskUpdatedArea = sf::IntRect(0, 0, 0, 0);
+    return area;
+}
+
+bool Mod::IsUpdatingBorderMask() const {
+    return m_BorderMaskTask != nullptr;
+}
+
+// Focused title of every tier for each province, only used to compare them.
+using FocusedTitlesSnapshot = std::vector<std::array<const Title*, (int) TitleType::COUNT>>;
+
+static void ComputeBorderMask(const sf::Image& provinceIdsImage, const FocusedTitlesSnapshot& focusedTitles, std::vector<sf::Uint8>& mask, uint stride, sf::IntRect area) {
+    // For each pixel, store the highest tier (+1) at which the province
+    // is different from one of its 4 neighbors, or 0 if it isn't on a border.
+    // Tier 0 is the province itself, then barony to empire (1 to 5) using the
+    // focused titles. Since the focused title of a tier only depends on the one
+    // of the tier below, a border at some tier is also a border at all lower tiers.
+    const sf::Uint8* pixels = provinceIdsImage.getPixelsPtr();
+    const uint width = provinceIdsImage.getSize().x;
+    const uint height = provinceIdsImage.getSize().y;
+
+    // Id+1 of the province of a pixel (see Mod::UpdateProvinceIdsImage).
+    const auto& GetIndex = [&](uint x, uint y) {
+        const sf::Uint8* pixel = pixels + (y * width + x) * 4;
+        return (uint) ((pixel[0] << 16) | (pixel[1] << 8) | pixel[2]);
+    };
+
+    const auto& GetBorderTier = [&](uint index, uint neighborIndex) {
+        if(index == 0 || neighborIndex == 0 || index > focusedTitles.size() || neighborIndex > focusedTitles.size())
+            return (int) TitleType::COUNT;
+
+        // Provinces without barony are different at every tier.
+        const auto& titles = focusedTitles[index - 1];
+        const auto& neighborTitles = focusedTitles[neighborIndex - 1];
+        if(titles[0] == nullptr || neighborTitles[0] == nullptr)
+            return (int) TitleType::COUNT;
+
+        for(int type = (int) TitleType::COUNT-1; type >= 0; type--) {
+            if(titles[type] != neighborTitles[type])
+                return type + 1;
+        }
+        return 0;
+    };
+
+    const uint left = area.left;
+    const uint right = area.left + area.width;
+    const uint rowsPerTile = std::max(1, 16384 / std::max(1, area.width));
+
+    ThreadPool::Get()->ParallelFor(area.height, rowsPerTile, [&](uint begin, uint end) {
+        // Cache the tier of the last pair of provinces in each direction.
+        uint cachedPairs[4][2] = {};
+        int cachedTiers[4] = { -1, -1, -1, -1 };
+
+        const auto& GetCachedBorderTier = [&](int direction, uint index, uint neighborIndex) {
+            if(cachedTiers[direction] < 0 || cachedPairs[direction][0] != index || cachedPairs[direction][1] != neighborIndex) {
+                cachedPairs[direction][0] = index;
+                cachedPairs[direction][1] = neighborIndex;
+                cachedTiers[direction] = GetBorderTier(index, neighborIndex);
+            }
+            return cachedTiers[direction];
+        };
+
+        for(uint y = area.top + begin; y < area.top + end; y++) {
+            for(uint x = left; x < right; x++) {
+                uint index = GetIndex(x, y);
+                int value = 0;
+
+                const auto& CheckNeighbor = [&](int direction, uint nx, uint ny) {
+                    uint neighborIndex = GetIndex(nx, ny);
+                    if(neighborIndex != index)
+                        value = std::max(value, GetCachedBorderTier(direction, index, neighborIndex) + 1);
+                };
 
-    while(title->GetLiegeTitle() != nullptr && (int) title->GetType() < (int) type && title->GetLiegeTitle()->HasSelectionFocus()) {
-        title = title->GetLiegeTitle();
+                if(x > 0) CheckNeighbor(0, x-1, y);
+                if(x + 1 < width) CheckNeighbor(1, x+1, y);
+                if(y > 0) CheckNeighbor(2, x, y-1);
+                if(y + 1 < height) CheckNeighbor(3, x, y+1);
+
+                mask[y * stride + x] = value;
+            }
+        }
+    });
+}
+
+static FocusedTitlesSnapshot GetFocusedTitlesSnapshot(const std::vector<std::array<SharedPtr<Title>, (int) TitleType::COUNT>>& focusedTitles) {
+    FocusedTitlesSnapshot snapshot(focusedTitles.size());
+    for(uint id = 0; id < focusedTitles.size(); id++) {
+        for(int type = 0; type < (int) TitleType::COUNT; type++)
+            snapshot[id][type] = focusedTitles[id][type].get();
     }
+    return snapshot;
+}
+
+void Mod::UpdateBorderMask(sf::IntRect area) {
+    const uint width = m_ProvinceIdsImage->getSize().x;
+    const uint height = m_ProvinceIdsImage->getSize().y;
+
+    // Rows are padded to a multiple of 4 pixels to be packed in RGBA texels.
+    const uint stride = (width + 3) / 4 * 4;
+    if(m_BorderMask.size() != stride * height || m_BorderMaskStride != stride) {
+        m_BorderMask.assign(stride * height, 0);
+        m_BorderMaskStride = stride;
+        area = sf::IntRect(0, 0, width, height);
+    }
+
+    ComputeBorderMask(*m_ProvinceIdsImage, GetFocusedTitlesSnapshot(m_ProvincesFocusedTitles), m_BorderMask, stride, area);
+
+    // Merge with the area that hasn't been uploaded yet, and with the area
+    // to compute again once the mask generated in the background is done.
+    m_BorderMaskUpdatedArea = Math::UnionRect(m_BorderMaskUpdatedArea, area);
+    if(m_BorderMaskTask != nullptr)
+        m_BorderMaskPendingArea = Math::UnionRect(m_BorderMaskPendingArea, area);
+}
+
+void Mod::UpdateBorderMaskAsync() {
+    // Generate the border mask of the whole map in a back buffer, from a snapshot
+    // of the focused titles, while the current mask keeps being displayed.
+    // The mask is swapped in by Mod::FlushBorderMaskUpdates() once it is done,
+    // which also starts it again if it was requested while it was generated.
+    m_BorderMaskGeneration++;
+    if(m_BorderMaskTask == nullptr)
+        this->SubmitBorderMaskTask();
+}
 
-    return title;
+void Mod::SubmitBorderMaskTask() {
+    const uint width = m_ProvinceIdsImage->getSize().x;
+    const uint height = m_ProvinceIdsImage->getSize().y;
+    const uint stride = (width + 3) / 4 * 4;
+
+    if(m_BorderMaskStride != stride) {
+        m_BorderMask.assign(stride * height, 0);
+        m_BorderMaskStride = stride;
+    }
+    m_BorderMaskBackBuffer = MakeShared<std::vector<sf::Uint8>>(stride * height, 0);
+    m_BorderMaskPendingArea = sf::IntRect(0, 0, 0, 0);
+    m_BorderMaskTaskGeneration = m_BorderMaskGeneration;
+
+    // The task only uses what it captures, so that the mod never has to wait for it.
+    m_BorderMaskTask = ThreadPool::Get()->Submit([idsImage = m_ProvinceIdsImage, backBuffer = m_BorderMaskBackBuffer, stride, snapshot = GetFocusedTitlesSnapshot(m_ProvincesFocusedTitles)]() {
+        const sf::IntRect area = sf::IntRect(0, 0, idsImage->getSize().x, idsImage->getSize().y);
+        ComputeBorderMask(*idsImage, snapshot, *backBuffer, stride, area);
+    });
 }
 
 int Mod::GetMaxProvinceId() const {
-    return m_ProvincesByIds.empty() ? -1 : m_ProvincesByIds.rbegin()->first;
+    return m_Provinces.empty() ? -1 : m_Provinces.back()->GetId();
+}
+
+std::span<const int> Mod::GetProvinceNeighbors(int provinceId) const {
+    if(provinceId < 0 || provinceId + 1 >= (int) m_AdjacencyOffsets.size())
+        return {};
+    return std::span<const int>(m_AdjacencyNeighbors.data() + m_AdjacencyOffsets[provinceId], m_AdjacencyOffsets[provinceId+1] - m_AdjacencyOffsets[provinceId]);
+}
+
+uint Mod::GetProvincesBorderLength(int provinceId, int otherProvinceId) const {
+    std::span<const int> neighbors = this->GetProvinceNeighbors(provinceId);
+    const auto& it = std::lower_bound(neighbors.begin(), neighbors.end(), otherProvinceId);
+
+    if(it == neighbors.end() || *it != otherProvinceId)
+        return 0;
+    return m_AdjacencyBorderLengths[m_AdjacencyOffsets[provinceId] + (it - neighbors.begin())];
+}
+
+bool Mod::AreProvincesAdjacent(int provinceId, int otherProvinceId) const {
+    return this->GetProvincesBorderLength(provinceId, otherProvinceId) > 0;
+}
+
+void Mod::ComputeProvincesAdjacencies(bool wrapHorizontally) {
+    // Scan the provinces image for every pair of 4-connected pixels of different
+    // provinces, counting the number of pixel edges shared by each pair.
+    const sf::Uint8* pixels = m_ProvinceImage.getPixelsPtr();
+    uint width = m_ProvinceImage.getSize().x;
+    uint height = m_ProvinceImage.getSize().y;
+    uint totalPixels = width * height;
+
+    const auto& GetColor = [&](uint index) {
+        const sf::Uint8* pixel = pixels + index*4;
+        return (uint32_t) ((pixel[0] << 24) | (pixel[1] << 16) | (pixel[2] << 8) | pixel[3]);
+    };
+
+    // Pairs of provinces ids (smallest id in the high bits) and their border length.
+    std::unordered_map<uint64_t, uint> borders;
+    std::mutex mutex;
+
+    ThreadPool::Get()->ParallelForPixels(totalPixels, [&](uint startIndex, uint endIndex) {
+        std::unordered_map<uint64_t, uint> chunkBorders;
+
+        // Cache the last looked up color of both the pixel and its neighbor,
+        // as most pixels are in the same province as the previous one.
+        uint32_t cachedColors[2] = { 0, 0 };
+        int cachedIds[2] = { -1, -1 };
+        bool cached[2] = { false, false };
+
+        const auto& GetProvinceId = [&](uint32_t color, int slot) {
+            if(!cached[slot] || cachedColors[slot] != color) {
+                const int* id = m_ProvincesIds.find(color);
+                cached[slot] = true;
+                cachedColors[slot] = color;
+                cachedIds[slot] = (id == nullptr) ? -1 : *id;
+            }
+            return cachedIds[slot];
+        };
+
+        const auto& AddBorder = [&](uint32_t color, uint32_t neighborColor) {
+            if(color == neighborColor)
+                return;
+            int id = GetProvinceId(color, 0);
+            int neighborId = GetProvinceId(neighborColor, 1);
+            if(id < 0 || neighborId < 0 || id == neighborId)
+                return;
+            uint64_t key = ((uint64_t) std::min(id, neighborId) << 32) | (uint32_t) std::max(id, neighborId);
+            chunkBorders[key]++;
+        };
+
+        uint x = startIndex % width;
+        uint y = startIndex / width;
+
+        for(uint index = startIndex; index < endIndex; index++) {
+            uint32_t color = GetColor(index);
+
+            if(x + 1 < width)
+                AddBorder(color, GetColor(index + 1));
+            else if(wrapHorizontally && width > 1)
+                AddBorder(color, GetColor(index + 1 - width));
+
+            if(y + 1 < height)
+                AddBorder(color, GetColor(index + width));
+
+            if(++x == width) {
+                x = 0;
+                y++;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const auto& [key, length] : chunkBorders)
+            borders[key] += length;
+    });
+
+    // Build the compressed rows from the degree of each province.
+    const uint provincesCount = this->GetMaxProvinceId() + 1;
+    m_AdjacencyOffsets.assign(provincesCount + 1, 0);
+    m_AdjacencyNeighbors.resize(borders.size() * 2);
+    m_AdjacencyBorderLengths.resize(borders.size() * 2);
+
+    for(const auto& [key, length] : borders) {
+        m_AdjacencyOffsets[(key >> 32) + 1]++;
+        m_AdjacencyOffsets[(key & 0xFFFFFFFF) + 1]++;
+    }
+    for(uint i = 0; i < provincesCount; i++)
+        m_AdjacencyOffsets[i+1] += m_AdjacencyOffsets[i];
+
+    std::vector<std::pair<int, uint>> edges(borders.size() * 2);
+    std::vector<uint> positions(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1);
+
+    for(const auto& [key, length] : borders) {
+        int a = key >> 32;
+        int b = key & 0xFFFFFFFF;
+        edges[positions[a]++] = { b, length };
+        edges[positions[b]++] = { a, length };
+    }
+
+    for(uint i = 0; i < provincesCount; i++)
+        std::sort(edges.begin() + m_AdjacencyOffsets[i], edges.begin() + m_AdjacencyOffsets[i+1]);
+
+    for(uint i = 0; i < edges.size(); i++) {
+        m_AdjacencyNeighbors[i] = edges[i].first;
+        m_AdjacencyBorderLengths[i] = edges[i].second;
+    }
+}
+
+void Mod::Tests() {
+    // A 4x2 map of three provinces, where provinces 1 and 3
+    // only touch each other across the wrapped edge:
+    // 1 1 2 3
+    // 1 2 2 3
+    Mod mod("");
+    const sf::Color colors[] = { sf::Color(10, 0, 0), sf::Color(20, 0, 0), sf::Color(30, 0, 0) };
+    for(int id = 1; id <= 3; id++)
+        mod.AddProvince(MakeShared<Province>(id, colors[id-1], fmt::format("province{}", id)));
+
+    const int map[] = { 1, 1, 2, 3, 1, 2, 2, 3 };
+    std::vector<sf::Uint8> pixels;
+    for(int id : map) {
+        const sf::Color& color = colors[id-1];
+        pixels.insert(pixels.end(), { color.r, color.g, color.b, color.a });
+    }
+    mod.m_ProvinceImage.create(4, 2, pixels.data());
+
+    const auto& Check = [&](bool wrap, int id, int otherId, uint expectedLength) {
+        uint length = mod.GetProvincesBorderLength(id, otherId);
+        if(length != expectedLength || mod.GetProvincesBorderLength(otherId, id) != expectedLength || mod.AreProvincesAdjacent(id, otherId) != (expectedLength > 0))
+            throw std::runtime_error(fmt::format("Failed tests for Mod::ComputeProvincesAdjacencies (wrap: {}) between {} and {}: expected {}, got {}", wrap, id, otherId, expectedLength, length));
+    };
+
+    for(bool wrap : { false, true }) {
+        mod.ComputeProvincesAdjacencies(wrap);
+        Check(wrap, 1, 2, 3);
+        Check(wrap, 2, 3, 2);
+        Check(wrap, 1, 3, wrap ? 2 : 0);
+
+        std::vector<int> neighbors(mod.GetProvinceNeighbors(1).begin(), mod.GetProvinceNeighbors(1).end());
+        if(neighbors != (wrap ? std::vector<int>{ 2, 3 } : std::vector<int>{ 2 }))
+            throw std::runtime_error(fmt::format("Failed tests for Mod::GetProvinceNeighbors (wrap: {}) of 1: got {} neighbors", wrap, neighbors.size()));
+    }
 }
 
 std::map<std::string, SharedPtr<Title>>& Mod::GetTitles() {
@@ -224,6 +688,7 @@ std::map<std::string, SharedPtr<Title>>& Mod::GetTitles() {
 }
 
 std::map<TitleType, std::vector<SharedPtr<Title>>>& Mod::GetTitlesByType() {
+    this->CompactTitlesByType();
     return m_TitlesByType;
 }
 
@@ -231,6 +696,14 @@ std::map<int, SharedPtr<BaronyTitle>>& Mod::GetBaroniesByProvinceIds() {
     return m_BaroniesByProvinceIds;
 }
 
+const TitlesHierarchy& Mod::GetTitlesHierarchy() const {
+    return m_TitlesHierarchy;
+}
+
+InheritedAttributes& Mod::GetInheritedAttributes() {
+    return m_InheritedAttributes;
+}
+
 const OrderedMap<std::string, HoldingType>& Mod::GetHoldingTypes() const {
     return m_HoldingTypes;
 }
@@ -239,16 +712,41 @@ const OrderedMap<std::string, TerrainType>& Mod::GetTerrainTypes() const {
     return m_TerrainTypes;
 }
 
+StringPool& Mod::GetHoldingNames() {
+    return m_HoldingNames;
+}
+
+StringPool& Mod::GetTerrainNames() {
+    return m_TerrainNames;
+}
+
+StringPool& Mod::GetCultureNames() {
+    return m_CultureNames;
+}
+
+StringPool& Mod::GetReligionNames() {
+    return m_ReligionNames;
+}
+
+StringPool& Mod::GetFilePaths() {
+    return m_FilePaths;
+}
+
+StringPool& Mod::GetLocalizationStrings() {
+    return m_LocalizationStrings;
+}
+
 void Mod::AddTitle(SharedPtr<Title> title) {
-    // Add title to global titles map.
+    // Add title to global titles map, replacing any title with the same name.
+    const auto& it = m_Titles.find(title->GetName());
+    if(it != m_Titles.end() && it->second != title) {
+        this->EraseTitleByType(it->second);
+        m_TitlesHierarchy.Remove(it->second);
+    }
     m_Titles[title->GetName()] = title;
-
-    // Remove any titles with the same name from the lists before adding it.
-    m_TitlesByType[title->GetType()].erase(
-        std::remove_if(m_TitlesByType[title->GetType()].begin(), m_TitlesByType[title->GetType()].end(), [title](SharedPtr<Title> t) {
-            return t->GetName() == title->GetName();
-    }), m_TitlesByType[title->GetType()].end());
-    m_TitlesByType[title->GetType()].push_back(title);
+    m_TitlesNames.insert(title->GetName());
+    m_TitlesHierarchy.Add(title);
+    this->InsertTitleByType(title);
 
     // Add barony title to province-barony map.
     if(title->Is(TitleType::BARONY)) {
@@ -260,12 +758,22 @@ void Mod::AddTitle(SharedPtr<Title> title) {
 void Mod::RemoveTitle(SharedPtr<Title> title) {
     // Remove title from global titles map.
     m_Titles.erase(title->GetName());
-
-    // Remove any titles with the same name from the lists.
-    m_TitlesByType[title->GetType()].erase(
-        std::remove_if(m_TitlesByType[title->GetType()].begin(), m_TitlesByType[title->GetType()].end(), [title](SharedPtr<Title> t) {
-            return t->GetName() == title->GetName();
-    }), m_TitlesByType[title->GetType()].end());
+    m_TitlesNames.erase(title->GetName());
+    this->EraseTitleByType(title);
+
+    // Titles using it as their capital would export a deleted title, while
+    // history entries are only reported since they may be intended.
+    const std::set<TitleReference> references = m_TitlesHierarchy.GetReferences().Get(title->GetName());
+    uint historyReferencesCount = 0;
+    for(const TitleReference& reference : references) {
+        if(reference.type == ReferenceType::CAPITAL)
+            static_cast<HighTitle*>(reference.title)->SetCapitalTitle(nullptr);
+        else if(reference.type != ReferenceType::CULTURAL_NAME)
+            historyReferencesCount++;
+    }
+    if(historyReferencesCount > 0)
+        LOG_WARNING("Removed title {} is still referenced in {} history entries", title->GetName(), historyReferencesCount);
+    m_TitlesHierarchy.Remove(title);
 
     // Add barony title to province-barony map.
     if(title->Is(TitleType::BARONY)) {
@@ -274,14 +782,151 @@ void Mod::RemoveTitle(SharedPtr<Title> title) {
     }
 }
 
-void Mod::RenameTitle(SharedPtr<Title> title, std::string formerName) {
-    for(auto [n, t] : m_Titles) {
-        for(auto [date, history] : t->GetHistory()) {
-            if(history->ContainsKey("liege") && history->Get<std::string>("liege") == formerName) {
-                history->Put("liege", title->GetName());
-            }
+bool Mod::IsTitleNameTaken(const std::string& name) const {
+    return m_TitlesNames.count(name) > 0;
+}
+
+std::string Mod::GetAvailableTitleName(const std::string& name) {
+    if(!this->IsTitleNameTaken(name))
+        return name;
+
+    // Append the next number not tried yet for that name, so that
+    // generating many titles with the same name stays linear.
+    uint& counter = m_TitlesNamesCounters[name];
+    std::string availableName;
+    do {
+        availableName = name + std::to_string(++counter);
+    } while(this->IsTitleNameTaken(availableName));
+    return availableName;
+}
+
+void Mod::InsertTitleByType(const SharedPtr<Title>& title) {
+    // Position of each title in the list of its type (indexed by title id),
+    // to remove it in constant time (see Mod::EraseTitleByType).
+    const int id = title->GetId();
+    if(id >= (int) m_TitlesByTypeIndices.size())
+        m_TitlesByTypeIndices.resize(id + 1, -1);
+
+    std::vector<SharedPtr<Title>>& titles = m_TitlesByType[title->GetType()];
+    int& index = m_TitlesByTypeIndices[id];
+    if(index >= 0 && index < (int) titles.size() && titles[index] == title)
+        return;
+    index = titles.size();
+    titles.push_back(title);
+}
+
+void Mod::EraseTitleByType(const SharedPtr<Title>& title) {
+    const int id = title->GetId();
+    if(id < 0 || id >= (int) m_TitlesByTypeIndices.size())
+        return;
+
+    std::vector<SharedPtr<Title>>& titles = m_TitlesByType[title->GetType()];
+    const int index = m_TitlesByTypeIndices[id];
+    if(index < 0 || index >= (int) titles.size() || titles[index] != title)
+        return;
+
+    // Leave an empty slot so that the other titles keep their order (e.g. in the
+    // exported localization), the lists are compacted before being read.
+    titles[index] = nullptr;
+    m_TitlesByTypeIndices[id] = -1;
+    m_ErasedTitlesByType++;
+}
+
+void Mod::CompactTitlesByType() {
+    if(m_ErasedTitlesByType == 0)
+        return;
+
+    for(auto& [type, titles] : m_TitlesByType) {
+        uint count = 0;
+        for(uint i = 0; i < titles.size(); i++) {
+            if(titles[i] == nullptr)
+                continue;
+            m_TitlesByTypeIndices[titles[i]->GetId()] = count;
+            titles[count++] = std::move(titles[i]);
+        }
+        titles.resize(count);
+    }
+    m_ErasedTitlesByType = 0;
+}
+
+bool Mod::RenameTitle(SharedPtr<Title> title, std::string formerName) {
+    // Move the title to its new name in the registry, unless another title
+    // already uses it: nothing else is renamed then.
+    const auto& it = m_Titles.find(formerName);
+    if(it == m_Titles.end() || it->second != title || this->IsTitleNameTaken(title->GetName())) {
+        LOG_ERROR("Failed to rename title {} to {}: the name is already used", formerName, title->GetName());
+        return false;
+    }
+    m_Titles.erase(it);
+    m_TitlesNames.erase(formerName);
+    m_Titles[title->GetName()] = title;
+    m_TitlesNames.insert(title->GetName());
+
+    // Only the history entries referencing the former name need to be updated,
+    // the capitals point to the title itself (see TitleReferences).
+    TitleReferences& references = m_TitlesHierarchy.GetReferences();
+    for(const TitleReference& reference : references.Get(formerName)) {
+        if(reference.type == ReferenceType::LIEGE)
+            reference.title->GetHistory()[reference.date]->Put("liege", title->GetName());
+        else if(reference.type == ReferenceType::DE_JURE_LIEGE)
+            reference.title->GetHistory()[reference.date]->Put("de_jure_liege", title->GetName());
+    }
+    references.Rename(formerName, title->GetName());
+    return true;
+}
+
+void Mod::CheckReferences() {
+    const auto& danglingReferences = this->GetDanglingReferences();
+    if(!danglingReferences.empty()) {
+        const auto& [name, reference] = danglingReferences.front();
+        LOG_WARNING("Found {} references to undefined titles or cultures (e.g {} in {})", danglingReferences.size(), name, reference.title->GetName());
+    }
+
+    // Provinces only store the id of their culture and religion,
+    // the provinces using each of them are found in the index.
+    const auto& CheckProvincesReferences = [&](const StringPool& names, const auto& definitions, ProvinceAttribute attribute, const char* label) {
+        if(definitions.empty())
+            return;
+        for(uint id = 1; id < names.GetCount(); id++) {
+            std::size_t count = m_ProvincesIndex.GetAttribute(attribute, id).count();
+            if(count > 0 && definitions.count(names.Get(id)) == 0)
+                LOG_WARNING("Undefined {} {} is assigned to {} provinces", label, names.Get(id), count);
+        }
+    };
+    CheckProvincesReferences(m_CultureNames, m_Cultures, ProvinceAttribute::CULTURE, "culture");
+    CheckProvincesReferences(m_ReligionNames, m_Religions, ProvinceAttribute::RELIGION, "faith");
+
+    // Passable land provinces with a barony need a culture and a religion,
+    // either their own or the one of their county.
+    const auto& CheckProvincesInheritance = [&](ProvinceAttribute attribute, const char* label) {
+        std::size_t count = 0;
+        int example = -1;
+        (m_ProvincesIndex.GetFlag(ProvinceFlags::LAND) - m_ProvincesIndex.GetFlag(ProvinceFlags::IMPASSABLE)).for_each([&](uint id) {
+            if(m_BaroniesByProvinceIds.count(id) == 0 || m_InheritedAttributes.GetAttributeId(attribute, id) != 0)
+                return;
+            if(count++ == 0)
+                example = id;
+        });
+        if(count > 0)
+            LOG_WARNING("Found {} land provinces without {}, neither their own nor from their county (e.g {})", count, label, example);
+    };
+    CheckProvincesInheritance(ProvinceAttribute::CULTURE, "culture");
+    CheckProvincesInheritance(ProvinceAttribute::RELIGION, "faith");
+}
+
+std::vector<std::pair<std::string, TitleReference>> Mod::GetDanglingReferences() const {
+    // Cultures are only checked if there are any loaded.
+    std::vector<std::pair<std::string, TitleReference>> danglingReferences;
+    for(const auto& [name, references] : m_TitlesHierarchy.GetReferences().GetAll()) {
+        for(const TitleReference& reference : references) {
+            bool dangling = (reference.type == ReferenceType::CULTURAL_NAME)
+                ? !m_Cultures.empty() && m_Cultures.count(name) == 0
+                : m_Titles.count(name) == 0;
+            if(dangling)
+                danglingReferences.push_back({ name, reference });
         }
     }
+    return danglingReferences;
 }
 
 void Mod::HarmonizeTitlesColors(const std::vector<SharedPtr<Title>>& titles, sf::Color rgb, float hue, float saturation) {
@@ -349,14 +994,13 @@ void Mod::GenerateMissingProvinces() {
         colorPtr[1] = provincesPixels[index++]; // B
         index++;
         if(previousProvinceColor != provinceColor) {
-            if(m_Provinces.count(provinceColor) == 0) {
+            if(!m_ProvincesIds.contains(provinceColor)) {
                 // Skip ids that are already taken by another province.
-                while(m_ProvincesByIds.count(nextId) != 0)
+                while(this->GetProvinceById(nextId) != nullptr)
                     nextId++;
 
                 SharedPtr<Province> province = MakeShared<Province>(nextId, sf::Color(provinceColor), fmt::format("province_{}", nextId));
-                m_Provinces[province->GetColorId()] = province;
-                m_ProvincesByIds[province->GetId()] = province;
+                this->AddProvince(province);
                 count++;
                 nextId++;
             }
@@ -364,25 +1008,32 @@ void Mod::GenerateMissingProvinces() {
         previousProvinceColor = provinceColor;
     }
     LOG_INFO("Generated {} new provinces based on the province image", count);
+
+    // Same as when loading the mod: the spans and geometry of the new provinces
+    // are computed with the ids image, and the focused titles table (used for the
+    // titles colors and the border mask) covers their ids.
+    if(count > 0) {
+        this->UpdateProvinceIdsImage();
+        this->ComputeProvincesAdjacencies(Configuration::mapWrapHorizontally);
+        this->UpdateProvincesFocusedTitles();
+    }
 }
 
 void Mod::GenerateMissingBaronies() {
+    Bitset baronies;
+    for(const auto& [id, barony] : m_BaroniesByProvinceIds)
+        if(id >= 0) baronies.set(id);
+
+    const Bitset provinces = m_ProvincesIndex.GetFlag(ProvinceFlags::LAND)
+        - m_ProvincesIndex.GetFlag(ProvinceFlags::IMPASSABLE)
+        - baronies;
+
     int count = 0;
-    for(auto& [id, province] : m_ProvincesByIds) {
-        if(!province->HasFlag(ProvinceFlags::LAND))
-            continue;
-        if(province->HasFlag(ProvinceFlags::IMPASSABLE))
-            continue;
-        if(m_BaroniesByProvinceIds.count(id) > 0)
-            continue;
-        
+    provinces.for_each([&](uint id) {
+        const SharedPtr<Province>& province = this->GetProvinceById(id);
+
         // Make sure to use a title name that isn't already taken.
-        std::string baronyName = "b_" + String::ToLowercase(province->GetName());
-        int i = 1;
-        while(m_Titles.count(baronyName) > 0) {
-            baronyName = "b_" + String::ToLowercase(province->GetName()) + std::to_string(i);
-            i++;
-        }
+        std::string baronyName = this->GetAvailableTitleName("b_" + String::ToLowercase(province->GetName()));
 
         // Create a new barony title for that land province.
         SharedPtr<Title> title = MakeTitle(TitleType::BARONY, baronyName, province->GetColor(), false);
@@ -392,7 +1043,7 @@ void Mod::GenerateMissingBaronies() {
         // Add the barony title.
         this->AddTitle(title);
         count++;
-    }
+    });
     LOG_INFO("Generated {} new barony titles for passable land provinces without any", count);
 }
 
@@ -400,20 +1051,55 @@ void Mod::Load() {
     if(!this->HasMap())
         return;
 
-    if(!m_HeightmapImage.loadFromFile(m_Dir + "/map_data/heightmap.png")) {
-        LOG_ERROR("Failed to load heightmap image at ", m_Dir + "/map_data/heightmap.png");
-    }
-    if(!m_ProvinceImage.loadFromFile(m_Dir + "/map_data/provinces.png")) {
-        FATAL("Failed to load provinces image at ", m_Dir + "/map_data/provinces.png");
-    }
-    if(!m_RiversImage.loadFromFile(m_Dir + "/map_data/rivers.png")) {
-        LOG_ERROR("Failed to load rivers image at ", m_Dir + "/map_data/rivers.png");
-    }
+    // Decode the images in the background while parsing the files,
+    // the provinces image is only needed by LoadProvinceImage.
+    // The heightmap and rivers are converted to their compact form
+    // once decoded, without keeping their RGBA pixels.
+    bool provinceImageLoaded = false;
+    SharedPtr<Task> provinceImageTask = ThreadPool::Get()->Submit([&]() {
+        provinceImageLoaded = m_ProvinceImage.loadFromFile(m_Dir + "/map_data/provinces.png");
+    });
+    bool heightmapImageLoaded = false;
+    SharedPtr<Task> heightmapImageTask = ThreadPool::Get()->Submit([&]() {
+        sf::Image image;
+        heightmapImageLoaded = image.loadFromFile(m_Dir + "/map_data/heightmap.png");
+        m_HeightmapSize = image.getSize();
+        m_Heightmap = Image::ToGrayscale(image);
+    });
+    bool riversImageLoaded = false;
+    bool riversPaletteFits = true;
+    SharedPtr<Task> riversImageTask = ThreadPool::Get()->Submit([&]() {
+        sf::Image image;
+        riversImageLoaded = image.loadFromFile(m_Dir + "/map_data/rivers.png");
+        m_RiversSize = image.getSize();
+        riversPaletteFits = Image::ToIndexed(image, m_Rivers, m_RiversPalette);
+    });
+
+    // The tasks write in the mod and in the locals above: wait for all of
+    // them on every exit path, including an exception thrown while parsing.
+    struct WaitTasksOnExit {
+        std::vector<SharedPtr<Task>> tasks;
+        ~WaitTasksOnExit() {
+            for(const auto& task : tasks)
+                task->Wait();
+        }
+    } waitTasksOnExit{{ provinceImageTask, heightmapImageTask, riversImageTask }};
 
     this->LoadHoldingTypes();
     this->LoadTerrainTypes();
     this->LoadProvincesDefinition();
+
+    provinceImageTask->Wait();
+    if(!provinceImageLoaded) {
+        // FATAL exits without unwinding the stack.
+        heightmapImageTask->Wait();
+        riversImageTask->Wait();
+        FATAL("Failed to load provinces image at ", m_Dir + "/map_data/provinces.png");
+    }
     this->LoadProvinceImage();
+    this->UpdateProvinceIdsImage();
+    this->ComputeProvincesAdjacencies(Configuration::mapWrapHorizontally);
+
     this->LoadDefaultMapFile();
     this->LoadProvincesTerrain();
     this->LoadProvincesHistory();
@@ -422,6 +1108,21 @@ void Mod::Load() {
     this->LoadCultures();
     this->LoadReligions();
     this->LoadLocalization();
+    this->CheckReferences();
+
+    heightmapImageTask->Wait();
+    if(!heightmapImageLoaded) {
+        LOG_ERROR("Failed to load heightmap image at ", m_Dir + "/map_data/heightmap.png");
+    }
+    riversImageTask->Wait();
+    if(!riversImageLoaded) {
+        LOG_ERROR("Failed to load rivers image at ", m_Dir + "/map_data/rivers.png");
+    }
+    else if(!riversPaletteFits) {
+        LOG_ERROR("Rivers image has more than 256 colors at ", m_Dir + "/map_data/rivers.png");
+    }
+
+    this->UpdateProvincesFocusedTitles();
 }
 
 void Mod::LoadHoldingTypes() {
@@ -526,10 +1227,19 @@ void Mod::LoadDefaultMapFile() {
     SharedPtr<Parser::Object> result = Parser::ParseFile(m_Dir + "/map_data/default.map");
 
     // TODO: Coastal provinces??
+
+    const auto& SetFlag = [&](double provinceId, ProvinceFlags flag) {
+        const SharedPtr<Province>& province = this->GetProvinceById(provinceId);
+        if(province == nullptr) {
+            LOG_WARNING("Undefined province {} in default.map", provinceId);
+            return;
+        }
+        province->SetFlag(flag, true);
+    };
     
     const std::vector<double>& lakes = result->GetArray("lakes", std::vector<double>{});
     for(double provinceId : lakes) {
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::LAKE, true);
+        SetFlag(provinceId, ProvinceFlags::LAKE);
     }
     
     // TODO: Islands provinces??
@@ -537,104 +1247,223 @@ void Mod::LoadDefaultMapFile() {
 
     const std::vector<double>& seaZones = result->GetArray("sea_zones", std::vector<double>{});
     for(double provinceId : seaZones) {
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::SEA, true);
+        SetFlag(provinceId, ProvinceFlags::SEA);
     }
 
     const std::vector<double>& rivers = result->GetArray("river_provinces", std::vector<double>{});
     for(double provinceId : rivers) {
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::RIVER, true);
+        SetFlag(provinceId, ProvinceFlags::RIVER);
     }
     
     const std::vector<double>& impassableSeas = result->GetArray("impassable_seas", std::vector<double>{});
     for(double provinceId : impassableSeas) {
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::SEA, true);
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::IMPASSABLE, true);
+        SetFlag(provinceId, ProvinceFlags::SEA);
+        SetFlag(provinceId, ProvinceFlags::IMPASSABLE);
     }
     
     const std::vector<double>& impassableMountains = result->GetArray("impassable_mountains", std::vector<double>{});
     for(double provinceId : impassableMountains) {
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::LAND, true);
-        m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::IMPASSABLE, true);
+        SetFlag(provinceId, ProvinceFlags::LAND);
+        SetFlag(provinceId, ProvinceFlags::IMPASSABLE);
     }
 }
 
 void Mod::LoadProvinceImage() {
-    const auto& pixels = m_ProvinceImage.getPixelsPtr();
-    std::map<uint32_t, bool> colors;
+    // Report the pixels of the provinces image that can't belong to a province,
+    // the geometry of the provinces is computed from their spans once the ids
+    // image is generated (see Mod::UpdateProvincesGeometry).
+    const sf::Uint8* pixels = m_ProvinceImage.getPixelsPtr();
 
     uint width = m_ProvinceImage.getSize().x;
     uint height = m_ProvinceImage.getSize().y;
     uint totalPixels = width * height;
 
-    const auto& GetIndexPosition = [&](uint index) {
-        index = index - 4;
-        return sf::Vector2i((index / 4) % width, floor(index / (4*width)));
-    };
+    std::unordered_set<uint32_t> missingColors;
+    std::vector<uint> transparentPixels;
+    std::mutex mutex;
+
+    // Each chunk collects its own pixels and colors which are
+    // merged into the image ones once it is done.
+    ThreadPool::Get()->ParallelForPixels(totalPixels, [&](uint startIndex, uint endIndex) {
+        std::unordered_set<uint32_t> chunkMissingColors;
+        std::vector<uint> chunkTransparentPixels;
+        uint32_t previousColor = 0;
+
+        for(uint index = startIndex; index < endIndex; index++) {
+            const sf::Uint8* pixel = pixels + index*4;
+            uint32_t color = (pixel[0] << 24) | (pixel[1] << 16) | (pixel[2] << 8) | pixel[3];
+
+            if((color & 0xFF) != 0xFF)
+                chunkTransparentPixels.push_back(index);
+            else if((index == startIndex || color != previousColor) && !m_ProvincesIds.contains(color))
+                chunkMissingColors.insert(color);
+            previousColor = color;
+        }
 
-    // Split the image vertically between all the threads.
-    const int threadsCount = 4;
-    std::vector<UniquePtr<sf::Thread>> threads;
-    const uint threadRange = totalPixels / threadsCount;
-
-    for(uint i = 0; i < threadsCount; i++) {
-
-        threads.push_back(MakeUnique<sf::Thread>([&, i](){
-            uint startIndex = i * threadRange*4;
-            uint endIndex = (i == threadsCount-1) ? totalPixels*4 : (i+1) * threadRange*4;
-            uint index = startIndex;
-
-            sf::Uint32 color = 0x000000FF;
-            sf::Uint32 previousColor = 0x00000000;
-            bool hasProvince = false;
-
-            // Cast to edit directly the bytes of the color and pixels.
-            char* colorPtr = static_cast<char*>((void*) &color);
-
-            while(index < endIndex) {
-                // Copy the four bytes corresponding to RGBA from the provinces image pixels
-                // to the array for the titles image.
-                // The bytes need to be flipped, otherwise provinceColor would
-                // be ABGR and we couldn't find the associated title color in the map.
-                colorPtr[3] = pixels[index++]; // R
-                colorPtr[2] = pixels[index++]; // G
-                colorPtr[1] = pixels[index++]; // B
-                colorPtr[0] = pixels[index++]; // A
-
-                if((color & 0xFF) != 0xFF) {
-                    sf::Vector2i pos = GetIndexPosition(index-4);
-                    LOG_ERROR("Transparent pixel in province image at coordinates ({},{})", pos.x, pos.y);
-                    continue;
-                }
+        std::lock_guard<std::mutex> lock(mutex);
+        missingColors.insert(chunkMissingColors.begin(), chunkMissingColors.end());
+        transparentPixels.insert(transparentPixels.end(), chunkTransparentPixels.begin(), chunkTransparentPixels.end());
+    });
 
-                const auto& province = m_Provinces.find(color);
-                hasProvince = (previousColor == color && hasProvince) || (province != m_Provinces.end());
-                bool alreadySeen = (previousColor == color || colors.count(color) > 0);
+    std::sort(transparentPixels.begin(), transparentPixels.end());
+    for(uint index : transparentPixels) {
+        LOG_ERROR("Transparent pixel in province image at coordinates ({},{})", index % width, index / width);
+    }
+    for(uint32_t color : missingColors) {
+        LOG_ERROR("Color found in image but missing province from definition.csv: ({},{},{},{})", (color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+    }
+}
 
-                previousColor = color;
+void Mod::UpdateProvinceIdsImage() {
+    // Replace the color of each pixel by the id of its province so that shaders
+    // can index per-province data. Ids are offset by one to keep 0 for pixels
+    // without province, as any color that is not in m_ProvincesIds.
+    //
+    // The pixels of each province are also stored as horizontal spans, so that
+    // operations on a province only go through its own pixels.
+
+    // A border mask generated in the background keeps the previous ids image
+    // alive, but is outdated: it is generated again once it is done.
+    if(m_BorderMaskTask != nullptr)
+        m_BorderMaskGeneration++;
+    const sf::Uint8* pixels = m_ProvinceImage.getPixelsPtr();
+    uint width = m_ProvinceImage.getSize().x;
+    uint height = m_ProvinceImage.getSize().y;
+    uint totalPixels = width * height;
 
-                if(!alreadySeen) {
-                    colors[color] = true;
-                }
+    std::vector<sf::Uint8> idsPixels(totalPixels * 4);
 
-                if(!alreadySeen && !hasProvince) {
-                    LOG_ERROR("Color found in image but missing province from definition.csv: ({},{},{},{})", pixels[index-4], pixels[index-3], pixels[index-2], pixels[index-1]);
-                    continue;
-                }
+    // Spans of each chunk of rows with the index (id+1) of their province,
+    // in the order of the pixels.
+    const uint rowsPerChunk = std::max(1u, 16384 / std::max(1u, width));
+    std::vector<std::vector<std::pair<uint, ProvinceSpan>>> chunksSpans((height + rowsPerChunk - 1) / rowsPerChunk);
 
-                if(hasProvince) {
-                    if(!alreadySeen) {
-                        sf::Vector2i pos = GetIndexPosition(index-4);
-                        province->second->SetImagePosition(pos);
-                    }
-                    province->second->IncrementImagePixelsCount();
+    ThreadPool::Get()->ParallelFor(height, rowsPerChunk, [&](uint startRow, uint endRow) {
+        std::vector<std::pair<uint, ProvinceSpan>>& spans = chunksSpans[startRow / rowsPerChunk];
+
+        for(uint y = startRow; y < endRow; y++) {
+            uint32_t previousColor = 0;
+            uint index = 0;
+
+            for(uint x = 0; x < width; x++) {
+                uint i = y * width + x;
+                const sf::Uint8* pixel = pixels + i*4;
+                uint32_t color = (pixel[0] << 24) | (pixel[1] << 16) | (pixel[2] << 8) | pixel[3];
+
+                if(x == 0 || color != previousColor) {
+                    previousColor = color;
+                    const int* id = m_ProvincesIds.find(color);
+                    index = (id == nullptr || *id < 0) ? 0 : *id + 1;
+                    if(index > 0)
+                        spans.push_back({index, ProvinceSpan{y, x, x}});
                 }
+                if(index > 0)
+                    spans.back().second.x1 = x + 1;
+
+                idsPixels[i*4 + 0] = (index >> 16) & 0xFF;
+                idsPixels[i*4 + 1] = (index >> 8) & 0xFF;
+                idsPixels[i*4 + 2] = index & 0xFF;
+                idsPixels[i*4 + 3] = 0xFF;
             }
-        }));
-        threads[threads.size()-1]->launch();
+        }
+    });
+
+    m_ProvinceIdsImage = MakeShared<sf::Image>();
+    m_ProvinceIdsImage->create(width, height, idsPixels.data());
+
+    // Group the spans by province in compressed sparse rows,
+    // keeping them sorted by row and then by column.
+    const uint provincesCount = this->GetMaxProvinceId() + 1;
+    m_SpansOffsets.assign(provincesCount + 1, 0);
+    for(const auto& spans : chunksSpans) {
+        for(const auto& [index, span] : spans)
+            m_SpansOffsets[index]++;
+    }
+    for(uint id = 0; id < provincesCount; id++)
+        m_SpansOffsets[id + 1] += m_SpansOffsets[id];
+
+    m_Spans.resize(m_SpansOffsets[provincesCount]);
+    std::vector<uint> positions(m_SpansOffsets.begin(), m_SpansOffsets.end() - 1);
+    for(const auto& spans : chunksSpans) {
+        for(const auto& [index, span] : spans)
+            m_Spans[positions[index - 1]++] = span;
+    }
+
+    this->UpdateProvincesGeometry();
+}
+
+void Mod::UpdateProvincesGeometry() {
+    // The area, bounding box and centroid of each province
+    // only go through its spans, which are sorted by row.
+    std::vector<std::pair<SharedPtr<Province>, sf::Vector2i>> provincesFirstPixel;
+
+    for(const auto& province : m_Provinces) {
+        std::span<const ProvinceSpan> spans = this->GetProvinceSpans(province->GetId());
+        if(spans.empty()) {
+            province->SetImagePixelsCount(0);
+            continue;
+        }
+
+        uint pixelsCount = 0;
+        uint minX = spans.front().x0;
+        uint maxX = spans.front().x1;
+        uint64_t sumX = 0, sumY = 0;
+        for(const ProvinceSpan& span : spans) {
+            const uint length = span.x1 - span.x0;
+            pixelsCount += length;
+            minX = std::min(minX, span.x0);
+            maxX = std::max(maxX, span.x1);
+            sumX += (uint64_t) (span.x0 + span.x1 - 1) * length / 2;
+            sumY += (uint64_t) span.row * length;
+        }
+        const uint minY = spans.front().row;
+        const uint maxY = spans.back().row;
+
+        province->SetImagePixelsCount(pixelsCount);
+        province->SetImageBoundingBox(sf::IntRect(minX, minY, maxX - minX, maxY - minY + 1));
+        province->SetImageCentroid(sf::Vector2f((double) sumX / pixelsCount, (double) sumY / pixelsCount));
+        provincesFirstPixel.push_back({province, sf::Vector2i(spans.front().x0, spans.front().row)});
+    }
+
+    // The position of a province is its pixel the farthest from its borders,
+    // which unlike the centroid is always inside the province.
+    ThreadPool::Get()->ParallelFor(provincesFirstPixel.size(), 1, [&](uint begin, uint end) {
+        for(uint i = begin; i < end; i++) {
+            const auto& [province, firstPixel] = provincesFirstPixel[i];
+            sf::Vector2i position = Image::GetInteriorPoint(m_ProvinceImage, province->GetColorId(), province->GetImageBoundingBox(), firstPixel);
+            province->SetImagePosition(position);
+        }
+    });
+}
+
+std::span<const ProvinceSpan> Mod::GetProvinceSpans(int provinceId) const {
+    if(provinceId < 0 || provinceId + 1 >= (int) m_SpansOffsets.size())
+        return {};
+    return std::span<const ProvinceSpan>(m_Spans.data() + m_SpansOffsets[provinceId], m_SpansOffsets[provinceId + 1] - m_SpansOffsets[provinceId]);
+}
+
+bool Mod::SetProvinceColor(const SharedPtr<Province>& province, sf::Color color) {
+    // Recolor the pixels of the province in the provinces image through its spans.
+    // The province keeps its id so the ids image, adjacencies... are unchanged.
+    color.a = 255;
+    if(color == province->GetColor())
+        return true;
+
+    if(m_ProvincesIds.contains(color.toInteger())) {
+        LOG_ERROR("Color ({},{},{}) is already used by province {}", color.r, color.g, color.b, m_ProvincesIds.at(color.toInteger()));
+        return false;
     }
 
-    for(auto& thread : threads)
-        thread->wait();
+    m_ProvincesIds.erase(province->GetColorId());
+    province->SetColor(color);
+    m_ProvincesIds.insert(province->GetColorId(), province->GetId());
+
+    for(const ProvinceSpan& span : this->GetProvinceSpans(province->GetId())) {
+        for(uint x = span.x0; x < span.x1; x++)
+            m_ProvinceImage.setPixel(x, span.row, color);
+    }
+    m_ProvinceImageModified = true;
+    return true;
 }
 
 void Mod::LoadProvincesDefinition() {
@@ -661,15 +1490,14 @@ void Mod::LoadProvincesDefinition() {
 
         SharedPtr<Province> province = MakeShared<Province>(id, sf::Color(r, g, b), name);
 
-        if(m_ProvincesByIds.count(id) > 0)
+        if(this->GetProvinceById(id) != nullptr)
             LOG_ERROR("Several provinces with same id: {}", id);
-        if(m_Provinces.count(province->GetColorId()) > 0)
-            LOG_ERROR("Several provinces with same color: {},{}", id, m_Provinces.at(province->GetColorId())->GetId());
+        if(m_ProvincesIds.contains(province->GetColorId()))
+            LOG_ERROR("Several provinces with same color: {},{}", id, m_ProvincesIds.at(province->GetColorId()));
         if(id != lastId+1)
             LOG_ERROR("Ids in definitions.csv are not sequential: {} to {}", lastId, id);
 
-        m_Provinces[province->GetColorId()] = province;
-        m_ProvincesByIds[province->GetId()] = province;
+        this->AddProvince(province);
         lastId = id;
     }
 }
@@ -682,11 +1510,14 @@ void Mod::LoadProvincesTerrain() {
     m_DefaultCoastalSeaTerrain = result->Get("default_coastal_sea", std::string("sea"));
 
     // Set default terrain for all provinces (especially for those without any in files).
-    for(const auto& [colorId, province] : m_Provinces) {
-        std::string defaultTerrain = m_DefaultLandTerrain;
+    const uint defaultLandTerrain = m_TerrainNames.Intern(m_DefaultLandTerrain);
+    const uint defaultSeaTerrain = m_TerrainNames.Intern(m_DefaultSeaTerrain);
+    const uint defaultCoastalSeaTerrain = m_TerrainNames.Intern(m_DefaultCoastalSeaTerrain);
+    for(const auto& province : m_Provinces) {
+        uint defaultTerrain = defaultLandTerrain;
         if(province->HasFlag(ProvinceFlags::SEA))
-            defaultTerrain = (province->HasFlag(ProvinceFlags::COASTAL) ? m_DefaultCoastalSeaTerrain : m_DefaultSeaTerrain);
-        province->SetTerrain(defaultTerrain);
+            defaultTerrain = (province->HasFlag(ProvinceFlags::COASTAL) ? defaultCoastalSeaTerrain : defaultSeaTerrain);
+        province->SetTerrainId(defaultTerrain);
     }
 
     for(const auto& [key, pair] : result->GetEntries()) {
@@ -707,7 +1538,8 @@ void Mod::LoadProvincesTerrain() {
             terrain = (std::string) (*value);
         }
 
-        if(m_ProvincesByIds.count(provinceId) == 0) {
+        const SharedPtr<Province>& province = this->GetProvinceById(provinceId);
+        if(province == nullptr) {
             LOG_WARNING("Terrain type assigned to undefined province: {}", provinceId);
             continue;
         }
@@ -717,20 +1549,29 @@ void Mod::LoadProvincesTerrain() {
             continue;
         }
 
-        m_ProvincesByIds[provinceId]->SetTerrain(terrain);
+        province->SetTerrainId(m_TerrainNames.Intern(terrain));
 
-        if(!m_ProvincesByIds[provinceId]->HasFlag(ProvinceFlags::SEA))
-            m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::LAND, true);
+        if(!province->HasFlag(ProvinceFlags::SEA))
+            province->SetFlag(ProvinceFlags::LAND, true);
     }
 }
 
+// Hash of the block of a definition in the content of its file, recorded with its
+// span to check that the file wasn't modified before it is read back when exporting.
+static uint64_t HashSourceBlock(std::string_view content, File::Span span) {
+    if(span.IsEmpty() || span.end > content.size())
+        return 0;
+    return File::Hash(content.substr(span.begin, span.end - span.begin));
+}
+
 void Mod::LoadProvincesHistory() {
     std::set<std::string> filesPath = File::ListFiles(m_Dir + "/history/provinces/");
 
     for(const auto& filePath : filesPath) {
         if(!filePath.ends_with(".txt"))
             continue;
-        SharedPtr<Parser::Object> data = Parser::ParseFile(filePath);
+        std::string content = File::ReadString(filePath);
+        SharedPtr<Parser::Object> data = Parser::Parse(content);
         
         for(auto& [key, pair] : data->GetEntries()) {
             if(!std::holds_alternative<double>(key))
@@ -738,15 +1579,22 @@ void Mod::LoadProvincesHistory() {
             auto& [op, value] = pair;
             int provinceId = std::get<double>(key);
 
+            const SharedPtr<Province>& province = this->GetProvinceById(provinceId);
+            if(province == nullptr) {
+                LOG_WARNING("History assigned to undefined province: {}", provinceId);
+                continue;
+            }
+
             if(value->ContainsKey("culture"))
-                m_ProvincesByIds[provinceId]->SetCulture(value->Get<std::string>("culture"));
+                province->SetCultureId(m_CultureNames.Intern(value->Get<std::string>("culture")));
             if(value->ContainsKey("religion"))
-                m_ProvincesByIds[provinceId]->SetReligion(value->Get<std::string>("religion"));
+                province->SetReligionId(m_ReligionNames.Intern(value->Get<std::string>("religion")));
             if(value->ContainsKey("holding"))
-                m_ProvincesByIds[provinceId]->SetHolding(value->Get<std::string>("holding"));
+                province->SetHoldingId(m_HoldingNames.Intern(value->Get<std::string>("holding")));
 
-            if(!m_HoldingTypes.contains(m_ProvincesByIds[provinceId]->GetHolding())) {
-                LOG_WARNING("Undefined holding type '{}' assigned to province {}", m_ProvincesByIds[provinceId]->GetHolding(), provinceId);
+            const std::string& holding = m_HoldingNames.Get(province->GetHoldingId());
+            if(!m_HoldingTypes.contains(holding)) {
+                LOG_WARNING("Undefined holding type '{}' assigned to province {}", holding, provinceId);
                 continue;
             }
 
@@ -756,8 +1604,8 @@ void Mod::LoadProvincesHistory() {
             value->Remove("religion");
             value->Remove("holding");
 
-            m_ProvincesByIds[provinceId]->SetOriginalFilePath(filePath);
-            m_ProvincesByIds[provinceId]->SetOriginalData(value);
+            province->SetOriginalFilePathId(m_FilePaths.Intern(filePath));
+            province->SetOriginalData(value, HashSourceBlock(content, value->GetSpan()));
         }
     }
 }
@@ -782,7 +1630,7 @@ void Mod::LoadTitlesHistory() {
                 continue;
             }
 
-            m_Titles[key]->SetOriginalHistoryFilePath(filePath);
+            m_Titles[key]->SetOriginalHistoryFilePathId(m_FilePaths.Intern(filePath));
 
             // 2. Loop over dates in the title history.
             for(auto& [k2, pair2] : value->GetEntries()) {
@@ -922,15 +1770,15 @@ void Mod::LoadLocalization() {
 
             switch(locType) {
                 case NAME:
-                    it->second->SetLocName("english", value);
+                    it->second->SetLocName(m_LocalizationStrings, "english", value);
                     countNames++;
                     break;
                 case ADJECTIVE:
-                    it->second->SetLocAdjective("english", value);
+                    it->second->SetLocAdjective(m_LocalizationStrings, "english", value);
                     countAdjectives++;
                     break;
                 case ARTICLE:
-                    it->second->SetLocArticle("english", value);
+                    it->second->SetLocArticle(m_LocalizationStrings, "english", value);
                     countArticles++;
                     break;
             }
@@ -955,13 +1803,15 @@ void Mod::LoadTitles() {
 
     for(int i = 0; i < (int) TitleType::COUNT; i++)
         m_TitlesByType[(TitleType) i] = std::vector<SharedPtr<Title>>();
+    m_ErasedTitlesByType = 0;
 
     for(const auto& filePath : filesPath) {
         if(!filePath.ends_with(".txt"))
             continue;
         // fmt::println("loading titles from {}", filePath);
-        SharedPtr<Parser::Object> data = Parser::ParseFile(filePath);
-        std::vector<SharedPtr<Title>> titles = ParseTitles(filePath, data);
+        std::string content = File::ReadString(filePath);
+        SharedPtr<Parser::Object> data = Parser::Parse(content);
+        std::vector<SharedPtr<Title>> titles = ParseTitles(filePath, content, data);
     }
 
     LOG_INFO("Loaded {} titles from {} files", m_Titles.size(), filesPath.size());
@@ -970,7 +1820,7 @@ void Mod::LoadTitles() {
         LOG_INFO("Loaded {} {} titles", m_TitlesByType[(TitleType) i].size(), TitleTypeLabels[i]);
 }
 
-std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, SharedPtr<Parser::Object> data) {
+std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, std::string_view content, SharedPtr<Parser::Object> data) {
     std::vector<SharedPtr<Title>> titles;
 
     for(auto& [k, pair] : data->GetEntries()) {
@@ -1003,7 +1853,7 @@ std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, Shar
                 
                 if(!value->ContainsKey("province"))
                     LOG_ERROR("Barony title missing province id in definition: {}", key);
-                if(m_ProvincesByIds.count(baronyTitle->GetProvinceId()) == 0)
+                if(this->GetProvinceById(baronyTitle->GetProvinceId()) == nullptr)
                     LOG_ERROR("Barony title with undefined province id in definition: {},{}", key, baronyTitle->GetProvinceId());
                 if(m_BaroniesByProvinceIds.count(baronyTitle->GetProvinceId()) > 0) {
                     LOG_ERROR("Province {} has several assigned barony titles (e.g {})", baronyTitle->GetProvinceId(), key);
@@ -1015,7 +1865,7 @@ std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, Shar
             }
             else {
                 SharedPtr<HighTitle> highTitle = CastSharedPtr<HighTitle>(title);
-                std::vector<SharedPtr<Title>> dejureTitles = ParseTitles(filePath, value);
+                std::vector<SharedPtr<Title>> dejureTitles = ParseTitles(filePath, content, value);
 
                 if(landless && !dejureTitles.empty())
                     LOG_WARNING("Landless title has dejure vassals in definition: {}", key);
@@ -1067,11 +1917,13 @@ std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, Shar
             value->Remove("color");
             value->Remove("landless");
             value->Remove("cultural_names");
-            title->SetOriginalFilePath(filePath);
-            title->SetOriginalData(value);
+            title->SetOriginalFilePathId(m_FilePaths.Intern(filePath));
+            title->SetOriginalData(value, HashSourceBlock(content, value->GetSpan()));
 
             m_Titles[key] = title;
-            m_TitlesByType[type].push_back(title);
+            m_TitlesNames.insert(key);
+            m_TitlesHierarchy.Add(title);
+            this->InsertTitleByType(title);
             titles.push_back(title);
         }
         catch(const std::runtime_error& e) {
@@ -1082,7 +1934,95 @@ std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, Shar
     return titles;
 }
 
+// Contents of the original files of provinces and titles, read before their
+// directory is cleared by the export to read back their definitions.
+// The whole file is only parsed if a definition has to be found by its key.
+struct Mod::SourceFile {
+    std::string content;
+    SharedPtr<Parser::Object> data;
+};
+
+static void ReadSourceFile(Mod::SourceFiles& sources, const std::string& filePath) {
+    if(!filePath.empty() && !sources.contains(filePath) && std::filesystem::exists(filePath))
+        sources[filePath].content = File::ReadString(filePath);
+}
+
+// Block of a definition in its original file including its curly brackets, empty if
+// the span doesn't match the block it was recorded for (e.g. the file has been
+// modified outside of the editor since it was loaded).
+static std::string_view GetSourceBlock(const Mod::SourceFiles& sources, const std::string& filePath, File::Span span, uint64_t hash) {
+    if(span.IsEmpty())
+        return std::string_view();
+    const auto it = sources.find(filePath);
+    if(it != sources.end() && span.end <= it->second.content.size()) {
+        std::string_view block = std::string_view(it->second.content).substr(span.begin, span.end - span.begin);
+        if(block.front() == '{' && block.back() == '}' && File::Hash(block) == hash)
+            return block;
+    }
+    return std::string_view();
+}
+
+// Definition of a key in the parsed data of a file, searched in the
+// nested objects too as titles are defined in the block of their liege.
+static SharedPtr<Parser::Object> FindSourceData(const SharedPtr<Parser::Object>& data, const Parser::Scalar& key) {
+    if(data->ContainsKey(key)) {
+        SharedPtr<Parser::Object> value = data->GetObject(key);
+        if(value->Is(Parser::ObjectType::OBJECT))
+            return value;
+    }
+    for(const auto& [k, pair] : data->GetEntries()) {
+        if(!pair.second->Is(Parser::ObjectType::OBJECT))
+            continue;
+        SharedPtr<Parser::Object> value = FindSourceData(pair.second, key);
+        if(value != nullptr)
+            return value;
+    }
+    return nullptr;
+}
+
+// Parse again the block of a definition, or use the data kept by the
+// entity if it doesn't have one (see Province::SetOriginalData).
+// If the block has been modified, the definition is read back from
+// the whole parsed file instead, where it is found by its key.
+static SharedPtr<Parser::Object> ReadSourceData(Mod::SourceFiles& sources, const std::string& filePath, File::Span span, uint64_t hash, const Parser::Scalar& key, const SharedPtr<Parser::Object>& data) {
+    if(data != nullptr)
+        return data;
+    if(span.IsEmpty())
+        return MakeShared<Parser::Object>();
+
+    std::string_view block = GetSourceBlock(sources, filePath, span, hash);
+    try {
+        if(!block.empty())
+            return Parser::Parse(std::string(block.substr(1, block.size() - 2)));
+
+        const auto it = sources.find(filePath);
+        if(it != sources.end()) {
+            Mod::SourceFile& source = it->second;
+            // Set to an empty object first to parse the file only once, even if it fails.
+            if(source.data == nullptr) {
+                source.data = MakeShared<Parser::Object>();
+                source.data = Parser::Parse(source.content);
+            }
+
+            SharedPtr<Parser::Object> value = FindSourceData(source.data, key);
+            if(value != nullptr) {
+                LOG_WARNING("Original definition of {} at {}:{} has been modified, reading it back by its key", key, filePath, span.begin);
+                // The callers modify the data, and it isn't a block of the file anymore.
+                SharedPtr<Parser::Object> copy = MakeShared<Parser::Object>(*value);
+                copy->SetSpan(File::Span());
+                return copy;
+            }
+        }
+        LOG_WARNING("Failed to read back original definition of {} at {}:{}", key, filePath, span.begin);
+    }
+    catch(const std::runtime_error& e) {
+        LOG_WARNING("Failed to parse original definition of {} at {}:{}: {}", key, filePath, span.begin, e.what());
+    }
+    return MakeShared<Parser::Object>();
+}
+
 void Mod::Export() {
+    this->ExportProvinceImage();
     this->ExportDefaultMapFile();
     this->ExportProvincesDefinition();
     this->ExportProvincesTerrain();
@@ -1094,6 +2034,19 @@ void Mod::Export() {
     this->ExportLocalization();
 }
 
+void Mod::ExportProvinceImage() {
+    // The provinces image is only written if provinces have been recolored,
+    // as encoding the image is slow and it must match definition.csv.
+    if(!m_ProvinceImageModified)
+        return;
+
+    if(!m_ProvinceImage.saveToFile(m_Dir + "/map_data/provinces.png")) {
+        LOG_ERROR("Failed to export provinces image at ", m_Dir + "/map_data/provinces.png");
+        return;
+    }
+    m_ProvinceImageModified = false;
+}
+
 void Mod::ExportDefaultMapFile() {
     // Read the file and keep all values except for the terrain flags
     // such as: sea_zones, impassable_seas, lakes, impassable_mountains, river_provinces
@@ -1114,22 +2067,18 @@ void Mod::ExportDefaultMapFile() {
     data->Remove("lakes");
     data->Remove("impassable_mountains");
 
-    for(const auto& [id, province] : m_ProvincesByIds) {
-        if(province->HasFlag(ProvinceFlags::SEA)) {
-            zonesData->GetObject("sea_zones")->Push((double) id);
-            if(province->HasFlag(ProvinceFlags::IMPASSABLE))
-                zonesData->GetObject("impassable_seas")->Push((double) id);
-        }
-        else if(province->HasFlag(ProvinceFlags::IMPASSABLE)) {
-            zonesData->GetObject("impassable_mountains")->Push((double) id);
-        }
+    const auto& PushIds = [&](const std::string& key, const Bitset& provinces) {
+        SharedPtr<Parser::Object> list = zonesData->GetObject(key);
+        provinces.for_each([&](uint id) { list->Push((double) id); });
+    };
+    const Bitset& sea = m_ProvincesIndex.GetFlag(ProvinceFlags::SEA);
+    const Bitset& impassable = m_ProvincesIndex.GetFlag(ProvinceFlags::IMPASSABLE);
 
-        if(province->HasFlag(ProvinceFlags::LAKE))
-            zonesData->GetObject("lakes")->Push((double) id);
-            
-        if(province->HasFlag(ProvinceFlags::RIVER))
-            zonesData->GetObject("river_provinces")->Push((double) id);
-    }
+    PushIds("sea_zones", sea);
+    PushIds("impassable_seas", sea & impassable);
+    PushIds("impassable_mountains", impassable - sea);
+    PushIds("lakes", m_ProvincesIndex.GetFlag(ProvinceFlags::LAKE));
+    PushIds("river_provinces", m_ProvincesIndex.GetFlag(ProvinceFlags::RIVER));
 
     // TODO: add error log if file can't be opened.
 
@@ -1170,18 +2119,8 @@ void Mod::ExportProvincesDefinition() {
     file << "0;0;0;0;x;x;\n";
 
     // "IDs must be sequential, or your game will crash."
-    // That's why it is needed to make a sorted list of the provinces.
-    // std::vector<SharedPtr<Province>> provincesSorted;
-    // for(auto&[colorId, province] : m_Provinces) {
-    //     provincesSorted.push_back(province);
-    // }
-    // std::sort(provincesSorted.begin(), provincesSorted.end(), [=](SharedPtr<Province>& a, SharedPtr<Province>& b) {
-    //     return a->GetId() < b->GetId();
-    // });
-    // std::map already sorts key in increasing order
-    // so there is no need to sort it again.
-
-    for(auto& [id, province] : m_ProvincesByIds) {
+    // The provinces are already sorted by id (see Mod::AddProvince).
+    for(const auto& province : m_Provinces) {
         fmt::println(file, 
             "{};{};{};{};{};x;",
             province->GetId(),
@@ -1203,13 +2142,13 @@ void Mod::ExportProvincesTerrain() {
     fmt::println(file, "default_coastal_sea={}", m_DefaultCoastalSeaTerrain);
     fmt::println(file, "\n");
 
-    for(auto& [id, province] : m_ProvincesByIds) {
+    for(const auto& province : m_Provinces) {
         if(!province->HasFlag(ProvinceFlags::LAND) || province->HasFlag(ProvinceFlags::IMPASSABLE))
             continue;
         fmt::println(file,
             "{}={}",
             province->GetId(),
-            province->GetTerrain()
+            m_TerrainNames.Get(province->GetTerrainId())
         );
     }
 
@@ -1226,56 +2165,105 @@ void Mod::ExportProvincesHistory() {
     // in disorder.
 
     std::string dir = m_Dir + "/history/provinces";
+
+    SourceFiles sources;
+    for(const auto& province : m_Provinces)
+        ReadSourceFile(sources, m_FilePaths.Get(province->GetOriginalFilePathId()));
+
     std::filesystem::remove_all(dir);
     std::filesystem::create_directories(dir);
 
-    for(const auto& kingdomTitle : m_TitlesByType[TitleType::KINGDOM]) {
+    // Whether the value of an attribute is the one of the original definition.
+    // Id 0 is the default of an absent key, but may also be a name written
+    // explicitly (e.g. "holding = none"), so present keys compare their names.
+    const auto IsUnchanged = [](const SharedPtr<Parser::Object>& data, const char* key, const StringPool& names, uint id) {
+        if(!data->ContainsKey(key))
+            return id == 0;
+        return data->Get<std::string>(key) == names.Get(id);
+    };
+
+    for(const auto& kingdomTitle : this->GetTitlesByType()[TitleType::KINGDOM]) {
         SharedPtr<HighTitle> kingdomHighTitle = CastSharedPtr<HighTitle>(kingdomTitle);
 
         // Provinces history are grouped by kingdoms.
         std::string filePath = fmt::format("{}/00_{}_prov.txt", dir, kingdomTitle->GetName());
-        std::ofstream file = std::ofstream(filePath, std::ios::out);
+        std::string content;
+        auto out = std::back_inserter(content);
 
         for(const auto& duchyTitle : kingdomHighTitle->GetDejureTitles()) {
             SharedPtr<HighTitle> duchyHighTitle = CastSharedPtr<HighTitle>(duchyTitle);
 
-            fmt::println(file, "##### {} ############################\n", duchyTitle->GetName());
+            fmt::format_to(out, "##### {} ############################\n\n", duchyTitle->GetName());
 
             for(const auto& countyTitle : duchyHighTitle->GetDejureTitles()) {
                 SharedPtr<HighTitle> countyHighTitle = CastSharedPtr<HighTitle>(countyTitle);
-                fmt::println(file, "### {}", countyTitle->GetName());
+                fmt::format_to(out, "### {}\n", countyTitle->GetName());
 
                 for(const auto& baronyTitle : countyHighTitle->GetDejureTitles()) {
                     SharedPtr<BaronyTitle> baronyBaronyTitle = CastSharedPtr<BaronyTitle>(baronyTitle);
-                    SharedPtr<Province> province = m_ProvincesByIds[baronyBaronyTitle->GetProvinceId()];
+                    const SharedPtr<Province>& province = this->GetProvinceById(baronyBaronyTitle->GetProvinceId());
         
-                    if(!province->HasFlag(ProvinceFlags::LAND) || province->HasFlag(ProvinceFlags::IMPASSABLE))
+                    if(province == nullptr || !province->HasFlag(ProvinceFlags::LAND) || province->HasFlag(ProvinceFlags::IMPASSABLE))
                         continue;
                     
-                    SharedPtr<Parser::Object> data = province->GetOriginalData();
-                    if(!province->GetCulture().empty()) data->Put("culture", province->GetCulture());
-                    if(!province->GetReligion().empty()) data->Put("religion", province->GetReligion());
-                    data->Put("holding", province->GetHolding().empty() ? "none" : province->GetHolding());
+                    const std::string& originalFilePath = m_FilePaths.Get(province->GetOriginalFilePathId());
+                    SharedPtr<Parser::Object> data = ReadSourceData(sources, originalFilePath, province->GetOriginalSpan(), province->GetOriginalHash(), (double) province->GetId(), province->GetOriginalData());
+                    std::string_view source = GetSourceBlock(sources, originalFilePath, province->GetOriginalSpan(), province->GetOriginalHash());
+                    std::string block;
+
+                    // The original block is copied as is (with its comments and
+                    // formatting) if the attributes edited in the editor didn't change.
+                    if(!source.empty() && province->GetOriginalData() == nullptr
+                        && IsUnchanged(data, "culture", m_CultureNames, province->GetCultureId())
+                        && IsUnchanged(data, "religion", m_ReligionNames, province->GetReligionId())
+                        && IsUnchanged(data, "holding", m_HoldingNames, province->GetHoldingId())
+                    ) {
+                        block = fmt::format("{} = {}", province->GetId(), source);
+                    }
+                    else {
+                        data->Remove("culture");
+                        data->Remove("religion");
+                        data->Remove("holding");
+
+                        const std::string& holding = m_HoldingNames.Get(province->GetHoldingId());
+                        if(province->GetCultureId() != 0) data->Put("culture", m_CultureNames.Get(province->GetCultureId()));
+                        if(province->GetReligionId() != 0) data->Put("religion", m_ReligionNames.Get(province->GetReligionId()));
+                        data->Put("holding", holding.empty() ? "none" : holding);
+
+                        SharedPtr<Parser::Object> object = MakeShared<Parser::Object>();
+                        object->Put(province->GetId(), data);
+                        block = fmt::format("{}", object);
+                    }
 
-                    SharedPtr<Parser::Object> object = MakeShared<Parser::Object>();
-                    object->Put(province->GetId(), data);
+                    fmt::format_to(out, "# {}\n", province->GetName());
 
-                    fmt::println(file, "# {}", province->GetName());
-                    fmt::println(file, "{}", object);
+                    // The province is read back from the exported file from now on.
+                    const uint offset = content.size();
+                    fmt::format_to(out, "{}\n", block);
+                    const File::Span span = { offset + (uint) block.find('{'), offset + (uint) block.rfind('}') + 1 };
+                    province->SetOriginalFilePathId(m_FilePaths.Intern(filePath));
+                    province->SetOriginalSpan(span, HashSourceBlock(content, span));
                 }
 
-                fmt::println(file, "\n");
+                fmt::format_to(out, "\n\n");
             }
         }
+
+        std::ofstream file = std::ofstream(filePath, std::ios::out);
+        file << content;
+        file.close();
     }
 
     // Check if there are any provinces that couldn't be saved.
-    for(const auto& [id, province] : m_ProvincesByIds) {
+    for(const auto& province : m_Provinces) {
         if(!province->HasFlag(ProvinceFlags::LAND) || province->HasFlag(ProvinceFlags::IMPASSABLE))
             continue;
         SharedPtr<Title> kingdomTitle = this->GetProvinceLiegeTitle(province, TitleType::KINGDOM);
         if(kingdomTitle == nullptr) {
-            LOG_ERROR("Province cannot be saved because missing dejure kingdom tier liege: {}", id);
+            LOG_ERROR("Province cannot be saved because missing dejure kingdom tier liege: {}", province->GetId());
+
+            // Its original file has been removed, keep its history until it is saved.
+            province->SetOriginalData(ReadSourceData(sources, m_FilePaths.Get(province->GetOriginalFilePathId()), province->GetOriginalSpan(), province->GetOriginalHash(), (double) province->GetId(), province->GetOriginalData()), 0);
             continue;
         }
     }
@@ -1283,29 +2271,49 @@ void Mod::ExportProvincesHistory() {
 
 void Mod::ExportTitles() {
     std::string dir = m_Dir + "/common/landed_titles";
+
+    SourceFiles sources;
+    for(const auto& [name, title] : m_Titles)
+        ReadSourceFile(sources, m_FilePaths.Get(title->GetOriginalFilePathId()));
+
     std::filesystem::remove_all(dir);
     std::filesystem::create_directories(dir);
 
-    std::map<std::string, std::ofstream> files;
+    std::map<std::string, std::string> contents;
 
     for(const auto& [name, title] : m_Titles) {
         if(title->GetLiegeTitle() != nullptr)
             continue;
-        std::string filePath = title->GetOriginalFilePath();
+        std::string filePath = m_FilePaths.Get(title->GetOriginalFilePathId());
         if(filePath.empty())
             filePath = dir + "/01_landed_titles.txt";
-        if(files.count(filePath) == 0) {
-            files[filePath] = std::ofstream(filePath, std::ios::out);
-            File::EncodeToUTF8BOM(files[filePath]);
-        }
-        std::ofstream& file = files[filePath];
-        fmt::println(file, "{} = {{", title->GetName());
-        this->ExportTitle(title, file, 1);
-        fmt::println(file, "}}\n");
+        if(contents.count(filePath) == 0)
+            File::EncodeToUTF8BOM(contents[filePath]);
+        std::string& content = contents[filePath];
+        fmt::format_to(std::back_inserter(content), "{} = {{\n", title->GetName());
+        const uint begin = content.size() - 2;
+        this->ExportTitle(title, content, 1, sources);
+        fmt::format_to(std::back_inserter(content), "}}\n\n");
+
+        const File::Span span = { begin, (uint) content.size() - 2 };
+        title->SetOriginalFilePathId(m_FilePaths.Intern(filePath));
+        title->SetOriginalSpan(span, HashSourceBlock(content, span));
     }
 
-    for(auto& [key, file] : files)
+    for(auto& [filePath, content] : contents) {
+        std::ofstream file = std::ofstream(filePath, std::ios::out);
+        file << content;
         file.close();
+    }
+
+    // The vassals are read back from the file of their top liege from now on.
+    for(const auto& [name, title] : m_Titles) {
+        SharedPtr<Title> liege = title;
+        while(liege->GetLiegeTitle() != nullptr)
+            liege = liege->GetLiegeTitle();
+        if(liege != title)
+            title->SetOriginalFilePathId(liege->GetOriginalFilePathId());
+    }
 }
 
 void Mod::ExportTitlesHistory() {
@@ -1335,7 +2343,7 @@ void Mod::ExportTitlesHistory() {
     for(const auto& [name, title] : m_Titles) {
         if(title->GetHistory().size() == 0)
             continue;
-        std::string filePath = title->GetOriginalHistoryFilePath();
+        std::string filePath = m_FilePaths.Get(title->GetOriginalHistoryFilePathId());
         if(filePath.empty())
             filePath = dir + "/" + GetTitleFileName(title) + ".txt";
         if(files.count(filePath) == 0)
@@ -1360,19 +2368,39 @@ void Mod::ExportTitlesHistory() {
         file.close();
 }
 
-void Mod::ExportTitle(const SharedPtr<Title>& title, std::ofstream& file, int depth) {
+void Mod::ExportTitle(const SharedPtr<Title>& title, std::string& content, int depth, SourceFiles& sources) {
     std::string indent = std::string(depth, '\t');
-    SharedPtr<Parser::Object> data = (title->GetOriginalData() == nullptr) ? MakeShared<Parser::Object>() : title->GetOriginalData();
+    auto out = std::back_inserter(content);
+
+    // Remove the attributes edited in the editor and the dejure
+    // titles from the original definition, as in Mod::ParseTitles.
+    SharedPtr<Parser::Object> data = ReadSourceData(sources, m_FilePaths.Get(title->GetOriginalFilePathId()), title->GetOriginalSpan(), title->GetOriginalHash(), title->GetName(), title->GetOriginalData());
+    for(const Parser::Scalar& key : data->GetKeys()) {
+        if(!std::holds_alternative<std::string>(key))
+            continue;
+        try {
+            GetTitleTypeByName(std::get<std::string>(key));
+            data->Remove(key);
+        }
+        catch(const std::runtime_error& e) {}
+    }
+    data->Remove("color");
+    data->Remove("landless");
+    data->Remove("cultural_names");
+    if(title->Is(TitleType::BARONY))
+        data->Remove("province");
+    else if(!title->Is(TitleType::COUNTY))
+        data->Remove("capital");
 
-    #define EXPORT_PROPERTIES(key, value) fmt::println(file, "{}{} = {}", indent, key, value)
+    #define EXPORT_PROPERTIES(key, value) fmt::format_to(out, "{}{} = {}\n", indent, key, value)
 
     const auto ExportCulturalNames = [&]() {
         if(!title->GetCulturalNames().empty()) {
-            fmt::println(file, "\n{}cultural_names = {{", indent);
+            fmt::format_to(out, "\n{}cultural_names = {{\n", indent);
             for(auto [culture, name] : title->GetCulturalNames()) {
-                fmt::println(file, "{}\t{} = {}", indent, culture, name);
+                fmt::format_to(out, "{}\t{} = {}\n", indent, culture, name);
             }
-            fmt::println(file, "{}}}", indent);
+            fmt::format_to(out, "{}}}\n", indent);
         }
     };
 
@@ -1386,7 +2414,7 @@ void Mod::ExportTitle(const SharedPtr<Title>& title, std::ofstream& file, int de
         ExportCulturalNames();
 
         if(!data->GetEntries().empty())
-            fmt::println(file, "{}", Parser::Format::FormatObject(data, depth, true));
+            fmt::format_to(out, "{}\n", Parser::Format::FormatObject(data, depth, true));
     }
     else {
         SharedPtr<HighTitle> highTitle = CastSharedPtr<HighTitle>(title);
@@ -1395,9 +2423,9 @@ void Mod::ExportTitle(const SharedPtr<Title>& title, std::ofstream& file, int de
         // not have any holding type.
         if(title->Is(TitleType::COUNTY) && !highTitle->GetDejureTitles().empty()) {
             SharedPtr<BaronyTitle> vassalTitle = CastSharedPtr<BaronyTitle>(highTitle->GetDejureTitles().front());
-            if(m_ProvincesByIds.count(vassalTitle->GetProvinceId()) > 0) {
-                SharedPtr<Province> province = m_ProvincesByIds[vassalTitle->GetProvinceId()];
-                if(province->GetHolding() == "none") {
+            const SharedPtr<Province>& province = this->GetProvinceById(vassalTitle->GetProvinceId());
+            if(province != nullptr) {
+                if(province->GetHoldingId() == m_HoldingNames.Find("none")) {
                     LOG_ERROR("Capital barony {} of county {} does not have any holding", vassalTitle->GetName(), title->GetName());
                 }
             }
@@ -1412,12 +2440,15 @@ void Mod::ExportTitle(const SharedPtr<Title>& title, std::ofstream& file, int de
         ExportCulturalNames();
 
         if(!data->GetEntries().empty())
-            fmt::println(file, "\n{}", Parser::Format::FormatObject(data, depth, true));
+            fmt::format_to(out, "\n{}\n", Parser::Format::FormatObject(data, depth, true));
 
         for(const auto& dejureTitle : highTitle->GetDejureTitles()) {
-            fmt::println(file, "\n{}{} = {{", indent, dejureTitle->GetName());
-            this->ExportTitle(dejureTitle, file, depth+1);
-            fmt::println(file, "{}}}", indent);
+            fmt::format_to(out, "\n{}{} = {{\n", indent, dejureTitle->GetName());
+            const uint begin = content.size() - 2;
+            this->ExportTitle(dejureTitle, content, depth+1, sources);
+            fmt::format_to(out, "{}}}\n", indent);
+            const File::Span span = { begin, (uint) content.size() - 1 };
+            dejureTitle->SetOriginalSpan(span, HashSourceBlock(content, span));
         }
     }
 }
@@ -1430,11 +2461,11 @@ void Mod::ExportLocalization() {
     std::ofstream file(m_TitlesLocalizationFilePath);
 
     fmt::println(file, "l_english:");
-    for(auto [type, titles] : m_TitlesByType) {
+    for(const auto& [type, titles] : this->GetTitlesByType()) {
         for(auto title : titles) {
-            std::string name = title->GetLocName("english");
-            std::string adjective = title->GetLocAdjective("english");
-            std::string article = title->GetLocArticle("english");
+            std::string name = title->GetLocName(m_LocalizationStrings, "english");
+            std::string adjective = title->GetLocAdjective(m_LocalizationStrings, "english");
+            std::string article = title->GetLocArticle(m_LocalizationStrings, "english");
 
             if(!name.empty()) fmt::println(file, " {}: \"{}\"", title->GetName(), name);
             if(!adjective.empty()) fmt::println(file, " {}_adj: \"{}\"", title->GetName(), adjective);
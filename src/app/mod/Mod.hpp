@@ -1,35 +1,86 @@
 #pragma once
 
+#include "app/map/Title.hpp"
+
 class Mod {
 public:
+    // Width of the textures holding per-province data for
+    // the shaders, kept small to stay within the GPU limits.
+    static constexpr uint PROVINCES_TABLE_WIDTH = 1024;
+
     Mod(const std::string& dir);
+    ~Mod();
 
     std::string GetDir() const;
-    sf::Image& GetHeightmapImage();
+    sf::Vector2u GetHeightmapSize() const;
+    const std::vector<sf::Uint8>& GetHeightmap() const;
+    sf::Image GetHeightmapImage() const;
     sf::Image& GetProvinceImage();
-    sf::Image& GetRiversImage();
-    sf::Image GetTerrainImage();
-    sf::Image GetCultureImage();
-    sf::Image GetReligionImage();
-    sf::Image GetTitleImage(TitleType type);
+    const std::vector<sf::Uint8>& GetRivers() const;
+    const std::vector<sf::Uint32>& GetRiversPalette() const;
+    sf::Image GetRiversImage() const;
+    sf::Image& GetProvinceIdsImage();
+
+    // The ids image is replaced rather than modified when it is generated again,
+    // so this one can be read in the background while the mod is edited.
+    SharedPtr<const sf::Image> GetSharedProvinceIdsImage() const;
+    std::vector<sf::Uint32> GetTerrainColors();
+    std::vector<sf::Uint32> GetCultureColors();
+    std::vector<sf::Uint32> GetReligionColors();
+    sf::Image GetTerrainImage(sf::IntRect area = sf::IntRect());
+    sf::Image GetCultureImage(sf::IntRect area = sf::IntRect());
+    sf::Image GetReligionImage(sf::IntRect area = sf::IntRect());
+    sf::Image GetTitlesColorsImage();
     bool HasMap() const;
 
-    std::map<uint32_t, SharedPtr<Province>>& GetProvinces();
-    std::map<int, SharedPtr<Province>>& GetProvincesByIds();
+    const std::vector<SharedPtr<Province>>& GetProvinces() const;
+    const SharedPtr<Province>& GetProvinceById(int id) const;
+    const SharedPtr<Province>& GetProvinceByColor(sf::Uint32 colorId) const;
+    const ProvincesIndex& GetProvincesIndex() const;
+    SharedPtr<Province> GetProvinceAt(sf::Vector2i position) const;
     SharedPtr<Title> GetProvinceLiegeTitle(const SharedPtr<Province>& province, TitleType type);
     SharedPtr<Title> GetProvinceFocusedTitle(const SharedPtr<Province>& province, TitleType type);
+    void UpdateProvincesFocusedTitles();
+    void UpdateProvincesFocusedTitles(const SharedPtr<Title>& title);
+
+    const std::vector<sf::Uint8>& GetBorderMask() const;
+    uint GetBorderMaskStride() const;
+    sf::IntRect FlushBorderMaskUpdates();
+    bool IsUpdatingBorderMask() const;
+    void UpdateBorderMask(sf::IntRect area);
+    void UpdateBorderMaskAsync();
     int GetMaxProvinceId() const;
 
+    std::span<const ProvinceSpan> GetProvinceSpans(int provinceId) const;
+    bool SetProvinceColor(const SharedPtr<Province>& province, sf::Color color);
+
+    std::span<const int> GetProvinceNeighbors(int provinceId) const;
+    uint GetProvincesBorderLength(int provinceId, int otherProvinceId) const;
+    bool AreProvincesAdjacent(int provinceId, int otherProvinceId) const;
+    void ComputeProvincesAdjacencies(bool wrapHorizontally = false);
+
     std::map<std::string, SharedPtr<Title>>& GetTitles();
     std::map<TitleType, std::vector<SharedPtr<Title>>>& GetTitlesByType();
     std::map<int, SharedPtr<BaronyTitle>>& GetBaroniesByProvinceIds();
+    const TitlesHierarchy& GetTitlesHierarchy() const;
+    InheritedAttributes& GetInheritedAttributes();
 
     const OrderedMap<std::string, HoldingType>& GetHoldingTypes() const;
     const OrderedMap<std::string, TerrainType>& GetTerrainTypes() const;
 
+    StringPool& GetHoldingNames();
+    StringPool& GetTerrainNames();
+    StringPool& GetCultureNames();
+    StringPool& GetReligionNames();
+    StringPool& GetFilePaths();
+    StringPool& GetLocalizationStrings();
+
     void AddTitle(SharedPtr<Title> title);
     void RemoveTitle(SharedPtr<Title> title);
-    void RenameTitle(SharedPtr<Title> title, std::string formerName);
+    bool RenameTitle(SharedPtr<Title> title, std::string formerName);
+    bool IsTitleNameTaken(const std::string& name) const;
+    std::string GetAvailableTitleName(const std::string& name);
+    std::vector<std::pair<std::string, TitleReference>> GetDanglingReferences() const;
 
     void HarmonizeTitlesColors(const std::vector<SharedPtr<Title>>& titles, sf::Color color, float hue, float saturation);
     void GenerateMissingProvinces();
@@ -39,6 +90,7 @@ public:
     void LoadHoldingTypes();
     void LoadTerrainTypes();
     void LoadProvinceImage();
+    void UpdateProvinceIdsImage();
     void LoadDefaultMapFile();
     void LoadProvincesDefinition();
     void LoadProvincesTerrain();
@@ -48,37 +100,124 @@ public:
     void LoadCultures();
     void LoadReligions();
     void LoadLocalization();
+    void CheckReferences();
 
-    std::vector<SharedPtr<Title>> ParseTitles(const std::string& filePath, SharedPtr<Parser::Object> data);
+    std::vector<SharedPtr<Title>> ParseTitles(const std::string& filePath, std::string_view content, SharedPtr<Parser::Object> data);
 
     void Export();
+    void ExportProvinceImage();
     void ExportDefaultMapFile();
     void ExportProvincesDefinition();
     void ExportProvincesTerrain();
     void ExportProvincesHistory();
     void ExportTitles();
     void ExportTitlesHistory();
-    void ExportTitle(const SharedPtr<Title>& title, std::ofstream& file, int depth);
+    // Contents of the original files read back when exporting (see Mod.cpp).
+    struct SourceFile;
+    using SourceFiles = std::unordered_map<std::string, SourceFile>;
+    void ExportTitle(const SharedPtr<Title>& title, std::string& content, int depth, SourceFiles& sources);
 
     void ExportLocalization();
     void DeleteTitlesLocalization();
 
+    static void Tests();
+
 private:
+    void AddProvince(const SharedPtr<Province>& province);
+    void UpdateProvinceFocusedTitles(const SharedPtr<BaronyTitle>& barony);
+    void SubmitBorderMaskTask();
+    void UpdateProvincesGeometry();
+    void InsertTitleByType(const SharedPtr<Title>& title);
+    void EraseTitleByType(const SharedPtr<Title>& title);
+    void CompactTitlesByType();
+    sf::IntRect GetImageArea(sf::IntRect area) const;
+
     std::string m_Dir;
-    sf::Image m_HeightmapImage;
+
+    // The heightmap is grayscale so only one byte is kept per pixel, and
+    // the rivers are stored as indices in their palette (see Image::ToIndexed).
+    sf::Vector2u m_HeightmapSize;
+    std::vector<sf::Uint8> m_Heightmap;
+    sf::Vector2u m_RiversSize;
+    std::vector<sf::Uint8> m_Rivers;
+    std::vector<sf::Uint32> m_RiversPalette;
+
     sf::Image m_ProvinceImage;
-    sf::Image m_RiversImage;
 
-    std::map<uint32_t, SharedPtr<Province>> m_Provinces;
-    std::map<int, SharedPtr<Province>> m_ProvincesByIds;
+    // Id+1 of the province of each pixel stored in the RGB bytes (0 if there is none),
+    // shared with the border mask generated in the background.
+    SharedPtr<sf::Image> m_ProvinceIdsImage;
+
+    // Whether provinces have been recolored since the provinces image was loaded.
+    bool m_ProvinceImageModified;
+
+    // Provinces sorted by id, the index of each id in this array (-1 if there
+    // is no province with that id) and the id of each province color.
+    std::vector<SharedPtr<Province>> m_Provinces;
+    std::vector<int> m_ProvincesIndices;
+    ColorMap<int> m_ProvincesIds;
+
+    // Ids of the provinces with each flag and attribute.
+    ProvincesIndex m_ProvincesIndex;
+
+    // Pixels of the provinces as horizontal spans in compressed sparse rows indexed by
+    // province id: the spans of a province are stored in [offsets[id], offsets[id+1]).
+    std::vector<uint> m_SpansOffsets;
+    std::vector<ProvinceSpan> m_Spans;
+
+    // Adjacency graph of the provinces in compressed sparse rows indexed by province id:
+    // the neighbors of a province are stored in [offsets[id], offsets[id+1]) sorted by id,
+    // with the length in pixels of the border they share.
+    std::vector<uint> m_AdjacencyOffsets;
+    std::vector<int> m_AdjacencyNeighbors;
+    std::vector<uint> m_AdjacencyBorderLengths;
     
     std::map<std::string, SharedPtr<Title>> m_Titles;
     std::map<TitleType, std::vector<SharedPtr<Title>>> m_TitlesByType;
+    std::vector<int> m_TitlesByTypeIndices;
+    // Number of empty slots left in the lists by removed titles.
+    uint m_ErasedTitlesByType;
+    std::unordered_set<std::string> m_TitlesNames;
+    std::unordered_map<std::string, uint> m_TitlesNamesCounters;
     std::map<int, SharedPtr<BaronyTitle>> m_BaroniesByProvinceIds;
+    TitlesHierarchy m_TitlesHierarchy;
+    InheritedAttributes m_InheritedAttributes;
+
+    // Focused title of every tier for each province (indexed by province id),
+    // used to generate the titles colors table and the border mask.
+    std::vector<std::array<SharedPtr<Title>, (int) TitleType::COUNT>> m_ProvincesFocusedTitles;
+
+    // Highest tier of the borders of each pixel (see Mod::UpdateBorderMask), with rows
+    // padded to a multiple of 4 pixels, and the area not uploaded to the GPU yet.
+    std::vector<sf::Uint8> m_BorderMask;
+    uint m_BorderMaskStride;
+    sf::IntRect m_BorderMaskUpdatedArea;
+
+    // Border mask of the whole map being generated in the background (see
+    // Mod::UpdateBorderMaskAsync), and the area updated since it was started.
+    // The generation is increased each time the whole mask is outdated, the
+    // mask of a task started for an older generation is dropped.
+    SharedPtr<Task> m_BorderMaskTask;
+    SharedPtr<std::vector<sf::Uint8>> m_BorderMaskBackBuffer;
+    sf::IntRect m_BorderMaskPendingArea;
+    uint m_BorderMaskGeneration;
+    uint m_BorderMaskTaskGeneration;
 
     std::map<std::string, SharedPtr<Culture>> m_Cultures;
     std::map<std::string, SharedPtr<Religion>> m_Religions;
 
+    // Names of the holdings, terrains, cultures and religions assigned to
+    // provinces, which only store their id (see Province::GetCultureId).
+    StringPool m_HoldingNames;
+    StringPool m_TerrainNames;
+    StringPool m_CultureNames;
+    StringPool m_ReligionNames;
+
+    // Original files of the provinces and titles, and languages and localization
+    // of the titles, which are often identical (e.g. titles of the same file).
+    StringPool m_FilePaths;
+    StringPool m_LocalizationStrings;
+
     OrderedMap<std::string, HoldingType> m_HoldingTypes;
     OrderedMap<std::string, TerrainType> m_TerrainTypes;
 
@@ -12,7 +12,7 @@ Token::Token(TokenType type, TokenValue value)
 : m_Type(type), m_Value(value) {}
 
 Token::Token(const Token& token)
-: Token(token.GetType(), token.GetValue()) {}
+: m_Type(token.GetType()), m_Value(token.GetValue()), m_Span(token.GetSpan()) {}
 
 Token::~Token() {}
 
@@ -28,6 +28,14 @@ TokenValue Token::GetValue() const {
     return m_Value;
 }
 
+File::Span Token::GetSpan() const {
+    return m_Span;
+}
+
+void Token::SetSpan(File::Span span) {
+    m_Span = span;
+}
+
 // TODO: add a function lex from a stringstream or ifstream.
 
 std::deque<PToken> Parser::Lex(const std::string& content) {
@@ -37,9 +45,12 @@ std::deque<PToken> Parser::Lex(const std::string& content) {
     while(!reader.IsEmpty()) {
         // Save the cursor position.
         reader.Start();
+        uint begin = reader.GetCursor();
         PToken token = ReadToken(reader);
-        if(token != nullptr)
+        if(token != nullptr) {
+            token->SetSpan({ begin, (uint) reader.GetCursor() });
             tokens.push_back(token);
+        }
     }
 
     return tokens;
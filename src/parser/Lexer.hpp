@@ -32,10 +32,13 @@ namespace Parser {
         TokenType GetType() const;
         bool Is(TokenType type) const;
         TokenValue GetValue() const;
+        File::Span GetSpan() const;
+        void SetSpan(File::Span span);
 
     private:
         TokenType m_Type;
         TokenValue m_Value;
+        File::Span m_Span;
     };
 
     std::deque<PToken> Lex(const std::string& content);
@@ -13,7 +13,8 @@ Object::Object() :
 {}
 
 Object::Object(const Object& object) :
-    m_Value((object.m_Value == nullptr) ? nullptr : object.m_Value->Copy())
+    m_Value((object.m_Value == nullptr) ? nullptr : object.m_Value->Copy()),
+    m_Span(object.m_Span)
 {}
 
 Object::Object(const Scalar& value) : 
@@ -46,6 +47,14 @@ bool Object::Is(ObjectType type) const {
     return this->GetType() == type;
 }
 
+File::Span Object::GetSpan() const {
+    return m_Span;
+}
+
+void Object::SetSpan(File::Span span) {
+    m_Span = span;
+}
+
 void Object::ConvertToArray() {
     if(this->Is(ObjectType::ARRAY)) {
         return;
@@ -470,6 +479,7 @@ Object& Object::operator=(const Scalar& value) {
 
 Object& Object::operator=(const Object& value) {
     m_Value = value.GetHolder()->Copy();
+    m_Span = value.m_Span;
     return *this;
 }
 
@@ -623,6 +633,7 @@ SharedPtr<Object> Parser::Parse(std::deque<PToken>& tokens, uint depth) {
         tokens.pop_front();
 
         if(token->Is(TokenType::RIGHT_BRACE)) {
+            values->SetSpan({ 0, token->GetSpan().end });
             return values;
         }
 
@@ -672,6 +683,7 @@ SharedPtr<Object> Parser::Parse(std::deque<PToken>& tokens, uint depth) {
 
                     if(current->Is(ObjectType::OBJECT) && object->Is(ObjectType::OBJECT)) {
                         current->Merge(object);
+                        current->SetSpan(File::Span());
                     }
                     else if(object->Is(ObjectType::OBJECT)) {
                         current->Push(object);
@@ -750,6 +762,8 @@ SharedPtr<Object> Parser::Impl::ParseObject(std::deque<PToken>& tokens) {
         return ParseScalar(token, tokens);
     }
 
+    const uint begin = token->GetSpan().begin;
+
     // Handle lists: { 1 2 3 4 5 }
     // Check if two successive tokens are of the same type.
     // So, if there isn't any operators for the second tokens,
@@ -771,7 +785,11 @@ SharedPtr<Object> Parser::Impl::ParseObject(std::deque<PToken>& tokens) {
             return ParseList<SharedPtr<Object>>(tokens);
     }
     
-    return Parse(tokens, 1);
+    // The span of the object starts at the LEFT_BRACE token,
+    // Parse only knows where it ends.
+    SharedPtr<Object> object = Parse(tokens, 1);
+    object->SetSpan({ begin, object->GetSpan().end });
+    return object;
     // throw std::runtime_error("error: failed to parse node value.");
 }
 
@@ -52,6 +52,11 @@ namespace Parser {
             ObjectType GetArrayType() const;
             bool Is(ObjectType type) const;
 
+            // Curly brackets enclosing the object in the parsed content, if
+            // it was parsed from a single block (i.e. not merged with others).
+            File::Span GetSpan() const;
+            void SetSpan(File::Span span);
+
             void ConvertToArray();
 
             // Functions to use with ArrayHolder or ObjectHolder.
@@ -122,6 +127,7 @@ namespace Parser {
             const SharedPtr<ObjectHolder> GetObjectHolder() const;
 
             SharedPtr<AbstractHolder> m_Value;
+            File::Span m_Span;
     };
 
     class AbstractHolder {
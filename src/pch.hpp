@@ -5,12 +5,16 @@
 #include <string>
 #include <math.h>
 #include <vector>
+#include <array>
+#include <span>
 #include <variant>
 #include <deque>
 #include <set>
+#include <unordered_set>
 #include <functional>
 #include <random>
 #include <algorithm>
+#include <bit>
 #include <ranges>
 
 #ifdef _WIN32
@@ -59,13 +63,19 @@ class PropertiesTab;
 #include "util/Ptr.hpp"
 #include "util/Logger.hpp"
 #include "util/String.hpp"
+#include "util/StringPool.hpp"
 #include "util/Math.hpp"
 #include "util/File.hpp"
 #include "util/Color.hpp"
 #include "util/Date.hpp"
 #include "util/ScopedString.hpp"
+#include "util/ThreadPool.hpp"
 #include "util/Image.hpp"
+#include "util/TiledTexture.hpp"
 #include "util/OrderedMap.hpp"
+#include "util/ColorMap.hpp"
+#include "util/FlatMap.hpp"
+#include "util/Bitset.hpp"
 #include "app/Configuration.hpp"
 
 #include "app/map/TitleType.hpp"
@@ -0,0 +1,83 @@
+#pragma once
+
+// Set of small non-negative integers (such as province ids) stored as bits in
+// 64-bit words, so that intersections and differences are done a word at a time.
+// Sets of different sizes can be combined, missing words are considered empty.
+class Bitset {
+public:
+    Bitset() = default;
+
+    void set(uint index, bool value = true) {
+        const uint word = index / BITS;
+        if(word >= m_Words.size()) {
+            if(!value)
+                return;
+            m_Words.resize(word + 1, 0);
+        }
+        const uint64_t mask = uint64_t(1) << (index % BITS);
+        if(value) m_Words[word] |= mask;
+        else m_Words[word] &= ~mask;
+    }
+
+    bool test(uint index) const {
+        const uint word = index / BITS;
+        return word < m_Words.size() && (m_Words[word] >> (index % BITS)) & 1;
+    }
+
+    std::size_t count() const {
+        std::size_t count = 0;
+        for(uint64_t word : m_Words)
+            count += std::popcount(word);
+        return count;
+    }
+
+    bool empty() const {
+        return std::all_of(m_Words.begin(), m_Words.end(), [](uint64_t word) { return word == 0; });
+    }
+
+    void clear() {
+        m_Words.clear();
+    }
+
+    // Call a function with each index of the set in increasing order.
+    template <typename F>
+    void for_each(F&& function) const {
+        for(uint i = 0; i < m_Words.size(); i++) {
+            for(uint64_t word = m_Words[i]; word != 0; word &= word - 1)
+                function(i * BITS + std::countr_zero(word));
+        }
+    }
+
+    Bitset& operator|=(const Bitset& other) {
+        if(other.m_Words.size() > m_Words.size())
+            m_Words.resize(other.m_Words.size(), 0);
+        for(uint i = 0; i < other.m_Words.size(); i++)
+            m_Words[i] |= other.m_Words[i];
+        return *this;
+    }
+
+    Bitset& operator&=(const Bitset& other) {
+        if(m_Words.size() > other.m_Words.size())
+            m_Words.resize(other.m_Words.size());
+        for(uint i = 0; i < m_Words.size(); i++)
+            m_Words[i] &= other.m_Words[i];
+        return *this;
+    }
+
+    // Difference of the sets: remove the indices of the other set.
+    Bitset& operator-=(const Bitset& other) {
+        const std::size_t size = std::min(m_Words.size(), other.m_Words.size());
+        for(uint i = 0; i < size; i++)
+            m_Words[i] &= ~other.m_Words[i];
+        return *this;
+    }
+
+    friend Bitset operator|(Bitset a, const Bitset& b) { return a |= b; }
+    friend Bitset operator&(Bitset a, const Bitset& b) { return a &= b; }
+    friend Bitset operator-(Bitset a, const Bitset& b) { return a -= b; }
+
+private:
+    static constexpr uint BITS = 64;
+
+    std::vector<uint64_t> m_Words;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+// Hash map from colors (sf::Color::toInteger()) to values, stored in a single
+// array with open addressing so that lookups don't chase pointers.
+// The fully transparent black color (0) marks empty slots and can't be a key.
+template <typename V>
+class ColorMap {
+public:
+    ColorMap() : m_Slots(16), m_Size(0) {}
+
+    void insert(sf::Uint32 key, const V& value) {
+        if((m_Size + 1) * 4 > m_Slots.size() * 3)
+            this->rehash(m_Slots.size() * 2);
+
+        Slot& slot = m_Slots[this->find_slot(key)];
+        if(slot.key != key) {
+            slot.key = key;
+            m_Size++;
+        }
+        slot.value = value;
+    }
+
+    void erase(sf::Uint32 key) {
+        if(key == EMPTY)
+            return;
+        const std::size_t mask = m_Slots.size() - 1;
+        std::size_t index = this->find_slot(key);
+        if(m_Slots[index].key != key)
+            return;
+
+        // Shift back the following slots of the probe sequence
+        // that can't be reached anymore once the slot is emptied.
+        for(std::size_t next = (index + 1) & mask; m_Slots[next].key != EMPTY; next = (next + 1) & mask) {
+            std::size_t ideal = hash(m_Slots[next].key) & mask;
+            bool reachable = (index <= next) ? (index < ideal && ideal <= next) : (index < ideal || ideal <= next);
+            if(reachable)
+                continue;
+            m_Slots[index] = m_Slots[next];
+            index = next;
+        }
+        m_Slots[index] = Slot();
+        m_Size--;
+    }
+
+    // Pointer to the value of a key, nullptr if there is none.
+    const V* find(sf::Uint32 key) const {
+        if(key == EMPTY)
+            return nullptr;
+        const Slot& slot = m_Slots[this->find_slot(key)];
+        return (slot.key == key) ? &slot.value : nullptr;
+    }
+
+    bool contains(sf::Uint32 key) const {
+        return this->find(key) != nullptr;
+    }
+
+    const V& at(sf::Uint32 key) const {
+        const V* value = this->find(key);
+        if(value == nullptr) {
+            throw std::out_of_range("key not found");
+        }
+        return *value;
+    }
+
+    std::size_t size() const {
+        return m_Size;
+    }
+
+    bool empty() const {
+        return m_Size == 0;
+    }
+
+    void clear() {
+        m_Slots.assign(16, Slot());
+        m_Size = 0;
+    }
+
+private:
+    static constexpr sf::Uint32 EMPTY = 0;
+
+    struct Slot {
+        sf::Uint32 key = EMPTY;
+        V value = V();
+    };
+
+    static std::size_t hash(sf::Uint32 key) {
+        // Colors of provinces differ in their low bits, mix them in the high bits.
+        key *= 0x9E3779B1u;
+        return key ^ (key >> 15);
+    }
+
+    std::size_t find_slot(sf::Uint32 key) const {
+        const std::size_t mask = m_Slots.size() - 1;
+        std::size_t index = hash(key) & mask;
+        while(m_Slots[index].key != EMPTY && m_Slots[index].key != key)
+            index = (index + 1) & mask;
+        return index;
+    }
+
+    void rehash(std::size_t slotsCount) {
+        std::vector<Slot> slots(slotsCount);
+        slots.swap(m_Slots);
+        m_Size = 0;
+        for(const Slot& slot : slots) {
+            if(slot.key != EMPTY)
+                this->insert(slot.key, slot.value);
+        }
+    }
+
+    std::vector<Slot> m_Slots;
+    std::size_t m_Size;
+};
@@ -1,6 +1,15 @@
 #include "File.hpp"
 #include <filesystem>
 
+uint64_t File::Hash(std::string_view content) {
+    uint64_t hash = 14695981039346656037ull;
+    for(char c : content) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 std::set<std::string> File::ListFiles(const std::string& dirPath) {
     std::set<std::string> files;
     if(std::filesystem::exists(dirPath)) {
@@ -16,6 +25,11 @@ std::string File::ReadString(std::ifstream& file) {
     return ss.str();
 }
 
+std::string File::ReadString(const std::string& filePath) {
+    std::ifstream file(filePath);
+    return ReadString(file);
+}
+
 std::vector<std::vector<std::string>> File::ReadCSV(const std::string& filePath) {
     std::ifstream file(filePath);
     std::vector<std::vector<std::string>> lines;
@@ -44,4 +58,8 @@ std::vector<std::vector<std::string>> File::ReadCSV(const std::string& filePath)
 void File::EncodeToUTF8BOM(std::ofstream& file) {
     unsigned char bom[] = { 0xEF, 0xBB, 0xBF };
     file.write(reinterpret_cast<char*>(bom), sizeof(bom));
+}
+
+void File::EncodeToUTF8BOM(std::string& content) {
+    content.insert(0, "\xEF\xBB\xBF");
 }
\ No newline at end of file
@@ -1,10 +1,23 @@
 #pragma once
 
 namespace File {
+    // Range of bytes [begin, end) in the content of a file, empty if unknown.
+    struct Span {
+        uint begin = 0;
+        uint end = 0;
+
+        bool IsEmpty() const { return end <= begin; }
+    };
+
+    // FNV-1a hash of a content, to check that it didn't change since it was read.
+    uint64_t Hash(std::string_view content);
+
     std::set<std::string> ListFiles(const std::string& dirPath);
     
     std::string ReadString(std::ifstream& file);
+    std::string ReadString(const std::string& filePath);
     std::vector<std::vector<std::string>> ReadCSV(const std::string& filePath);
 
     void EncodeToUTF8BOM(std::ofstream& file);
+    void EncodeToUTF8BOM(std::string& content);
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+// Map stored as a vector of pairs sorted by key, for maps holding a few
+// entries (e.g. per-language strings of a title), that are smaller and
+// faster to iterate than a std::map. Inserting or erasing an entry moves
+// the following ones, which invalidates iterators.
+template <typename K, typename V>
+class FlatMap {
+public:
+    using value_type = std::pair<K, V>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    iterator begin() { return m_Entries.begin(); }
+    iterator end() { return m_Entries.end(); }
+    const_iterator begin() const { return m_Entries.begin(); }
+    const_iterator end() const { return m_Entries.end(); }
+
+    std::size_t size() const {
+        return m_Entries.size();
+    }
+
+    bool empty() const {
+        return m_Entries.empty();
+    }
+
+    void clear() {
+        m_Entries.clear();
+    }
+
+    iterator find(const K& key) {
+        iterator it = this->lower_bound(key);
+        return (it != m_Entries.end() && !(key < it->first)) ? it : m_Entries.end();
+    }
+
+    const_iterator find(const K& key) const {
+        const_iterator it = this->lower_bound(key);
+        return (it != m_Entries.end() && !(key < it->first)) ? it : m_Entries.end();
+    }
+
+    std::size_t count(const K& key) const {
+        return this->find(key) != m_Entries.end();
+    }
+
+    const V& at(const K& key) const {
+        const_iterator it = this->find(key);
+        if(it == m_Entries.end()) {
+            throw std::out_of_range("key not found");
+        }
+        return it->second;
+    }
+
+    V& operator[](const K& key) {
+        iterator it = this->lower_bound(key);
+        if(it == m_Entries.end() || key < it->first)
+            it = m_Entries.insert(it, value_type(key, V()));
+        return it->second;
+    }
+
+    iterator erase(iterator it) {
+        return m_Entries.erase(it);
+    }
+
+    std::size_t erase(const K& key) {
+        iterator it = this->find(key);
+        if(it == m_Entries.end())
+            return 0;
+        m_Entries.erase(it);
+        return 1;
+    }
+
+private:
+    iterator lower_bound(const K& key) {
+        return std::lower_bound(m_Entries.begin(), m_Entries.end(), key, [](const value_type& entry, const K& key) {
+            return entry.first < key;
+        });
+    }
+
+    const_iterator lower_bound(const K& key) const {
+        return std::lower_bound(m_Entries.begin(), m_Entries.end(), key, [](const value_type& entry, const K& key) {
+            return entry.first < key;
+        });
+    }
+
+    std::vector<value_type> m_Entries;
+};
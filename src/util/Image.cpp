@@ -1,11 +1,204 @@
 #include "Image.hpp"
 
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using MappedColors = std::unordered_map<sf::Uint32, sf::Uint32>;
+
+// A kernel replaces the colors of `count` RGBA pixels from `src` and writes
+// them to `dst`. Colors are looked up in the map as 0xRRGGBBAA integers
+// (see sf::Color::toInteger) and are copied as is if they aren't mapped.
+using MapPixelsKernel = void(*)(const sf::Uint8* src, sf::Uint8* dst, std::size_t count, const MappedColors& mappedColors);
+
+static inline sf::Uint32 LookupColor(const MappedColors& mappedColors, sf::Uint32 color) {
+    const auto& it = mappedColors.find(color);
+    return (it == mappedColors.end()) ? color : it->second;
+}
+
+static inline sf::Uint32 ReadColor(const sf::Uint8* pixel) {
+    return ((sf::Uint32) pixel[0] << 24) | ((sf::Uint32) pixel[1] << 16) | ((sf::Uint32) pixel[2] << 8) | (sf::Uint32) pixel[3];
+}
+
+static inline void WriteColor(sf::Uint8* pixel, sf::Uint32 color) {
+    pixel[0] = (color >> 24) & 0xFF; // R
+    pixel[1] = (color >> 16) & 0xFF; // G
+    pixel[2] = (color >> 8) & 0xFF;  // B
+    pixel[3] = color & 0xFF;         // A
+}
+
+static void MapPixelsScalar(const sf::Uint8* src, sf::Uint8* dst, std::size_t count, const MappedColors& mappedColors) {
+    if(count == 0)
+        return;
+
+    // Search for the corresponding target color in the mapped values only
+    // if it isn't the same color as the previous one.
+    sf::Uint32 previousColor = ReadColor(src);
+    sf::Uint32 replaceColor = LookupColor(mappedColors, previousColor);
+
+    for(std::size_t i = 0; i < count; i++) {
+        sf::Uint32 color = ReadColor(src + i*4);
+        if(color != previousColor) {
+            previousColor = color;
+            replaceColor = LookupColor(mappedColors, color);
+        }
+        WriteColor(dst + i*4, replaceColor);
+    }
+}
+
+#ifdef IMAGE_SIMD_X86
+
+// Resolve the replacement colors of a block of pixels, where `keys` are the
+// pixels as 0xRRGGBBAA integers and each bit of `boundaries` tells whether
+// a pixel starts a new run of identical colors. The map is only searched at
+// the start of a run, the other pixels reuse the last replacement color.
+static inline void ResolveRuns(sf::Uint32* keys, int lanes, unsigned int boundaries, sf::Uint32& replaceColor, const MappedColors& mappedColors) {
+    for(int j = 0; j < lanes; j++) {
+        if(boundaries & (1u << j))
+            replaceColor = LookupColor(mappedColors, keys[j]);
+        keys[j] = replaceColor;
+    }
+}
+
+__attribute__((target("avx2")))
+static void MapPixelsAVX2(const sf::Uint8* src, sf::Uint8* dst, std::size_t count, const MappedColors& mappedColors) {
+    if(count == 0)
+        return;
+
+    // Reverse the bytes of each pixel to go from the RGBA bytes of the image
+    // to the ABGR order of 0xRRGGBBAA integers in memory, and the other way around.
+    const __m256i swapMask = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+    );
+    // Rotate the pixels by one lane, so that each pixel faces the previous one.
+    const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i lastLane = _mm256_set1_epi32(7);
+
+    sf::Uint32 previousColor = ReadColor(src);
+    sf::Uint32 replaceColor = LookupColor(mappedColors, previousColor);
+    __m256i previousPixels = _mm256_shuffle_epi8(_mm256_set1_epi32((int) previousColor), swapMask);
+    __m256i replacePixels = _mm256_shuffle_epi8(_mm256_set1_epi32((int) replaceColor), swapMask);
+
+    alignas(32) sf::Uint32 keys[8];
+    std::size_t i = 0;
+
+    for(; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*) (src + i*4));
+
+        // Compare every pixel with the one before it (the first one with
+        // the last pixel of the previous block) to find where runs start.
+        __m256i shifted = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(pixels, rotate), previousPixels, 0x01);
+        __m256i equal = _mm256_cmpeq_epi32(pixels, shifted);
+        unsigned int boundaries = ~((unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(equal))) & 0xFF;
+
+        if(boundaries == 0) {
+            _mm256_storeu_si256((__m256i*) (dst + i*4), replacePixels);
+            continue;
+        }
+
+        _mm256_store_si256((__m256i*) keys, _mm256_shuffle_epi8(pixels, swapMask));
+        previousColor = keys[7];
+        ResolveRuns(keys, 8, boundaries, replaceColor, mappedColors);
+
+        _mm256_storeu_si256((__m256i*) (dst + i*4), _mm256_shuffle_epi8(_mm256_load_si256((const __m256i*) keys), swapMask));
+        previousPixels = _mm256_permutevar8x32_epi32(pixels, lastLane);
+        replacePixels = _mm256_shuffle_epi8(_mm256_set1_epi32((int) replaceColor), swapMask);
+    }
+
+    for(; i < count; i++) {
+        sf::Uint32 color = ReadColor(src + i*4);
+        if(color != previousColor) {
+            previousColor = color;
+            replaceColor = LookupColor(mappedColors, color);
+        }
+        WriteColor(dst + i*4, replaceColor);
+    }
+}
+
+__attribute__((target("ssse3")))
+static void MapPixelsSSSE3(const sf::Uint8* src, sf::Uint8* dst, std::size_t count, const MappedColors& mappedColors) {
+    if(count == 0)
+        return;
+
+    const __m128i swapMask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    sf::Uint32 previousColor = ReadColor(src);
+    sf::Uint32 replaceColor = LookupColor(mappedColors, previousColor);
+    __m128i previousPixels = _mm_shuffle_epi8(_mm_set1_epi32((int) previousColor), swapMask);
+    __m128i replacePixels = _mm_shuffle_epi8(_mm_set1_epi32((int) replaceColor), swapMask);
+
+    alignas(16) sf::Uint32 keys[8];
+    std::size_t i = 0;
+
+    // Same as the AVX2 kernel, with the 8 pixels split in two 128-bit halves.
+    for(; i + 8 <= count; i += 8) {
+        __m128i low = _mm_loadu_si128((const __m128i*) (src + i*4));
+        __m128i high = _mm_loadu_si128((const __m128i*) (src + i*4 + 16));
+
+        __m128i equalLow = _mm_cmpeq_epi32(low, _mm_alignr_epi8(low, previousPixels, 12));
+        __m128i equalHigh = _mm_cmpeq_epi32(high, _mm_alignr_epi8(high, low, 12));
+        unsigned int equal = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(equalLow))
+            | ((unsigned int) _mm_movemask_ps(_mm_castsi128_ps(equalHigh)) << 4);
+        unsigned int boundaries = ~equal & 0xFF;
+
+        if(boundaries == 0) {
+            _mm_storeu_si128((__m128i*) (dst + i*4), replacePixels);
+            _mm_storeu_si128((__m128i*) (dst + i*4 + 16), replacePixels);
+            continue;
+        }
+
+        _mm_store_si128((__m128i*) keys, _mm_shuffle_epi8(low, swapMask));
+        _mm_store_si128((__m128i*) (keys + 4), _mm_shuffle_epi8(high, swapMask));
+        previousColor = keys[7];
+        ResolveRuns(keys, 8, boundaries, replaceColor, mappedColors);
+
+        _mm_storeu_si128((__m128i*) (dst + i*4), _mm_shuffle_epi8(_mm_load_si128((const __m128i*) keys), swapMask));
+        _mm_storeu_si128((__m128i*) (dst + i*4 + 16), _mm_shuffle_epi8(_mm_load_si128((const __m128i*) (keys + 4)), swapMask));
+        previousPixels = _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 3, 3, 3));
+        replacePixels = _mm_shuffle_epi8(_mm_set1_epi32((int) replaceColor), swapMask);
+    }
+
+    for(; i < count; i++) {
+        sf::Uint32 color = ReadColor(src + i*4);
+        if(color != previousColor) {
+            previousColor = color;
+            replaceColor = LookupColor(mappedColors, color);
+        }
+        WriteColor(dst + i*4, replaceColor);
+    }
+}
+
+#endif
+
+// Pick the fastest kernel supported by the CPU.
+static MapPixelsKernel GetMapPixelsKernel() {
+#ifdef IMAGE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return MapPixelsAVX2;
+    if(__builtin_cpu_supports("ssse3"))
+        return MapPixelsSSSE3;
+#endif
+    return MapPixelsScalar;
+}
+
 sf::Image Image::MapPixels(const sf::Image& originalImage, std::function<void(std::unordered_map<sf::Uint32, sf::Uint32>&)> mapFunc) {
+    sf::IntRect area = sf::IntRect(0, 0, originalImage.getSize().x, originalImage.getSize().y);
+    return MapPixels(originalImage, area, mapFunc);
+}
+
+sf::Image Image::MapPixels(const sf::Image& originalImage, const sf::IntRect& area, std::function<void(std::unordered_map<sf::Uint32, sf::Uint32>&)> mapFunc) {
     // Used for benchmarking.
     sf::Clock clock;
 
+    static const MapPixelsKernel kernel = GetMapPixelsKernel();
+
     sf::Image image;
-    std::unordered_map<sf::Uint32, sf::Uint32> mappedColors;
+    MappedColors mappedColors;
 
     // Call the mapping function to associate which colors
     // are to be replaced by which.
@@ -14,82 +207,337 @@ sf::Image Image::MapPixels(const sf::Image& originalImage, std::function<void(st
     // fmt::println("mapping colors: {}", String::DurationFormat(clock.restart()));
     // fmt::println("mapped: {} colors", mappedColors.size())
 
-    uint width = originalImage.getSize().x;
-    uint height = originalImage.getSize().y;
+    uint originalWidth = originalImage.getSize().x;
+    uint width = area.width;
+    uint height = area.height;
     uint totalPixels = width * height;
 
     // Use vectors to avoid using SFML getters and setters for pixels.
-    const sf::Uint8* originalPixels = originalImage.getPixelsPtr();
-    std::vector<sf::Uint8> newPixels = std::vector<sf::Uint8>();
-    newPixels.reserve(totalPixels * 4);
+    const sf::Uint8* originalPixels = originalImage.getPixelsPtr() + (area.top * originalWidth + area.left) * 4;
+    std::vector<sf::Uint8> newPixels = std::vector<sf::Uint8>(totalPixels * 4);
 
     // fmt::println("image=[{}, {}]\tbytes={}", width, height, newPixels.capacity());
     // fmt::println("initializing pixels array: {}", String::DurationFormat(clock.restart()));
 
-    const int threadsCount = 6;
-    std::vector<UniquePtr<sf::Thread>> threads;
-
-    // Split the image vertically between all the threads.
-    // Need to be careful not to split a color from all its composites
-    // in the process (so by block of 4).
-    const uint threadRange = totalPixels / threadsCount;
-
-    for(uint i = 0; i < threadsCount; i++) {
-
-        threads.push_back(MakeUnique<sf::Thread>([&, i](){
-            uint startIndex = i * threadRange*4;
-            uint endIndex = (i == threadsCount-1) ? totalPixels*4 : (i+1) * threadRange*4;
-            uint index = startIndex;
-
-            sf::Uint32 color = 0x000000FF;
-            sf::Uint32 previousColor = 0x00000000;
-
-            // Cast to edit directly the bytes of the color and pixels.
-            // - colorPtr is used to read the color from the original image.
-            // - targetPtr is used to access the color composites (RGBA)
-            //   of the pixels from the array we are painting (in the new image).
-            // - replacePtr is the target color to paint on the new texture.
-            char* colorPtr = static_cast<char*>((void*) &color);
-            char* targetPtr = static_cast<char*>((void*) &newPixels[startIndex]);
-            char* replacePtr = NULL;
-
-            while(index < endIndex) {
-                // Copy the four bytes corresponding to RGBA from the original image pixels
-                // to the array for the new image.
-                // The bytes need to be flipped, otherwise color would be ABGR and
-                // we couldn't find the associated target color in the mapped values.
-                colorPtr[3] = originalPixels[index++]; // R
-                colorPtr[2] = originalPixels[index++]; // G
-                colorPtr[1] = originalPixels[index++]; // B
-                colorPtr[0] = originalPixels[index++]; // A
-
-                // Search for the corresponding target color in the mapped values only
-                // if it isn't the same color has the previous one.
-                if(previousColor != color) {
-                    const auto& it = mappedColors.find(color);
-                    replacePtr = (it == mappedColors.end()) ? colorPtr : static_cast<char*>((void*) &it->second);
-                }
-                
-                // Replace the bits of the pixel in the new image
-                // where each byte correspond to a color composite (RGBA).
-                *targetPtr++ = replacePtr[3]; // R
-                *targetPtr++ = replacePtr[2]; // G
-                *targetPtr++ = replacePtr[1]; // B
-                *targetPtr++ = replacePtr[0]; // A
-
-                previousColor = color;
-            }    
-        
-        }));
-        threads[threads.size()-1]->launch();
-    }
-
-    for(auto& thread : threads)
-        thread->wait();
+    // Split the image in chunks between all the threads of the pool.
+    // The rows of an area spanning the whole width are contiguous in memory,
+    // otherwise each row is mapped on its own.
+    if(width == originalWidth) {
+        ThreadPool::Get()->ParallelForPixels(totalPixels, [&](uint startIndex, uint endIndex) {
+            kernel(originalPixels + startIndex*4, newPixels.data() + startIndex*4, endIndex - startIndex, mappedColors);
+        });
+    }
+    else {
+        // Rows are grouped to get chunks of about the same size as ParallelForPixels.
+        ThreadPool::Get()->ParallelFor(height, std::max(1u, 16384 / std::max(1u, width)), [&](uint startRow, uint endRow) {
+            for(uint y = startRow; y < endRow; y++)
+                kernel(originalPixels + y*originalWidth*4, newPixels.data() + y*width*4, width, mappedColors);
+        });
+    }
     // fmt::println("filling pixels: {}", String::DurationFormat(clock.restart()));
 
     image.create(width, height, newPixels.data());
     // fmt::println("initializing image: {}", String::DurationFormat(clock.restart()));
 
     return image;
-}
\ No newline at end of file
+}
+
+sf::Image Image::MapIds(const sf::Image& idsImage, const sf::IntRect& area, const std::vector<sf::Uint32>& palette) {
+    const uint idsWidth = idsImage.getSize().x;
+    const uint width = area.width;
+    const uint height = area.height;
+    const sf::Uint8* idsPixels = idsImage.getPixelsPtr();
+
+    // The colors are stored as they are in memory (RGBA bytes) so pixels can be written directly.
+    std::vector<sf::Uint8> colors(std::max<std::size_t>(1, palette.size()) * 4, 0);
+    for(uint id = 0; id < palette.size(); id++)
+        WriteColor(&colors[id * 4], palette[id]);
+    const uint colorsCount = colors.size() / 4;
+
+    std::vector<sf::Uint8> pixels((std::size_t) width * height * 4);
+
+    // Rows are grouped to get chunks of about the same size as ParallelForPixels.
+    ThreadPool::Get()->ParallelFor(height, std::max(1u, 16384 / std::max(1u, width)), [&](uint startRow, uint endRow) {
+        for(uint y = startRow; y < endRow; y++) {
+            const sf::Uint8* src = idsPixels + ((std::size_t) (area.top + y) * idsWidth + area.left) * 4;
+            sf::Uint8* dst = pixels.data() + (std::size_t) y * width * 4;
+
+            for(uint x = 0; x < width; x++) {
+                uint id = (src[x*4] << 16) | (src[x*4 + 1] << 8) | src[x*4 + 2];
+                if(id >= colorsCount)
+                    id = 0;
+                std::memcpy(dst + x*4, &colors[id * 4], 4);
+            }
+        }
+    });
+
+    sf::Image image;
+    image.create(width, height, pixels.data());
+    return image;
+}
+
+// Felzenszwalb & Huttenlocher's squared euclidean distance transform
+// of a 1D sampled function, computed as the lower envelope of parabolas.
+static void DistanceTransform1D(const float* f, float* d, int n, std::vector<int>& v, std::vector<float>& z) {
+    const float inf = std::numeric_limits<float>::max();
+    int k = 0;
+    v[0] = 0;
+    z[0] = -inf;
+    z[1] = inf;
+
+    for(int q = 1; q < n; q++) {
+        float s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+        while(s <= z[k]) {
+            k--;
+            s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = inf;
+    }
+
+    k = 0;
+    for(int q = 0; q < n; q++) {
+        while(z[k+1] < q)
+            k++;
+        d[q] = (float) (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+// Replace each value of the grid by the squared distance to the nearest
+// cell of value 0, where the other cells must be set to a large value.
+static void DistanceTransform(std::vector<float>& grid, int width, int height) {
+    const int size = std::max(width, height);
+    std::vector<float> f(size), d(size), z(size + 1);
+    std::vector<int> v(size);
+
+    for(int x = 0; x < width; x++) {
+        for(int y = 0; y < height; y++)
+            f[y] = grid[y*width + x];
+        DistanceTransform1D(f.data(), d.data(), height, v, z);
+        for(int y = 0; y < height; y++)
+            grid[y*width + x] = d[y];
+    }
+
+    for(int y = 0; y < height; y++) {
+        std::copy(grid.begin() + y*width, grid.begin() + (y+1)*width, f.begin());
+        DistanceTransform1D(f.data(), &grid[y*width], width, v, z);
+    }
+}
+
+sf::Vector2i Image::GetInteriorPoint(const sf::Image& image, sf::Uint32 color, const sf::IntRect& box, sf::Vector2i fallback) {
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    const uint imageWidth = image.getSize().x;
+
+    // Sample large regions on a coarser grid to bound the memory and time spent.
+    const int maxSamples = 1 << 20;
+    int step = 1;
+    while((long) ((box.width + step - 1) / step) * ((box.height + step - 1) / step) > maxSamples)
+        step++;
+
+    // Add a border of one cell around the box so that the edges
+    // of the box are considered outside of the region.
+    const int width = (box.width + step - 1) / step + 2;
+    const int height = (box.height + step - 1) / step + 2;
+    std::vector<float> grid(width * height, 0.f);
+
+    for(int y = 1; y < height-1; y++) {
+        for(int x = 1; x < width-1; x++) {
+            uint px = box.left + (x-1) * step;
+            uint py = box.top + (y-1) * step;
+            if(ReadColor(pixels + (py * imageWidth + px) * 4) == color)
+                grid[y*width + x] = 1e20f;
+        }
+    }
+
+    DistanceTransform(grid, width, height);
+
+    const auto& it = std::max_element(grid.begin(), grid.end());
+    if(*it == 0.f)
+        return fallback;
+
+    int index = it - grid.begin();
+    return sf::Vector2i(box.left + (index % width - 1) * step, box.top + (index / width - 1) * step);
+}
+
+std::vector<sf::Uint8> Image::ToGrayscale(const sf::Image& image) {
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    const uint totalPixels = image.getSize().x * image.getSize().y;
+    std::vector<sf::Uint8> grayscale(totalPixels);
+
+    ThreadPool::Get()->ParallelForPixels(totalPixels, [&](uint startIndex, uint endIndex) {
+        for(uint i = startIndex; i < endIndex; i++)
+            grayscale[i] = pixels[i*4];
+    });
+    return grayscale;
+}
+
+sf::Image Image::FromGrayscale(sf::Vector2u size, const std::vector<sf::Uint8>& pixels) {
+    const uint totalPixels = size.x * size.y;
+    std::vector<sf::Uint8> newPixels(totalPixels * 4);
+
+    ThreadPool::Get()->ParallelForPixels(totalPixels, [&](uint startIndex, uint endIndex) {
+        for(uint i = startIndex; i < endIndex; i++) {
+            newPixels[i*4 + 0] = pixels[i];
+            newPixels[i*4 + 1] = pixels[i];
+            newPixels[i*4 + 2] = pixels[i];
+            newPixels[i*4 + 3] = 0xFF;
+        }
+    });
+
+    sf::Image image;
+    image.create(size.x, size.y, newPixels.data());
+    return image;
+}
+
+bool Image::ToIndexed(const sf::Image& image, std::vector<sf::Uint8>& indices, std::vector<sf::Uint32>& palette) {
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    const uint totalPixels = image.getSize().x * image.getSize().y;
+    std::unordered_map<sf::Uint32, sf::Uint8> colorsIndices;
+    bool fits = true;
+
+    indices.resize(totalPixels);
+    palette.clear();
+
+    // Only search for the index of a color at the start of a run of identical pixels.
+    sf::Uint32 previousColor = 0;
+    sf::Uint8 index = 0;
+
+    for(uint i = 0; i < totalPixels; i++) {
+        sf::Uint32 color = ReadColor(pixels + i*4);
+
+        if(i == 0 || color != previousColor) {
+            previousColor = color;
+            const auto& it = colorsIndices.find(color);
+
+            if(it != colorsIndices.end()) {
+                index = it->second;
+            }
+            else if(palette.size() < 256) {
+                index = palette.size();
+                colorsIndices[color] = index;
+                palette.push_back(color);
+            }
+            else {
+                index = 0;
+                fits = false;
+            }
+        }
+        indices[i] = index;
+    }
+    return fits;
+}
+
+sf::Image Image::FromIndexed(sf::Vector2u size, const std::vector<sf::Uint8>& indices, const std::vector<sf::Uint32>& palette) {
+    const uint totalPixels = size.x * size.y;
+    std::vector<sf::Uint8> newPixels(totalPixels * 4);
+
+    ThreadPool::Get()->ParallelForPixels(totalPixels, [&](uint startIndex, uint endIndex) {
+        for(uint i = startIndex; i < endIndex; i++)
+            WriteColor(&newPixels[i*4], (indices[i] < palette.size()) ? palette[indices[i]] : 0);
+    });
+
+    sf::Image image;
+    image.create(size.x, size.y, newPixels.data());
+    return image;
+}
+
+void Image::Tests() {
+    // Make sure the vectorized kernels are bit-exact with the scalar one
+    // on an image made of runs of random lengths, including single pixels
+    // and unmapped colors, and with pixel counts that leave a scalar tail.
+    std::mt19937 random(1453);
+    std::vector<sf::Uint32> palette;
+    MappedColors mappedColors;
+
+    for(int i = 0; i < 64; i++) {
+        sf::Uint32 color = random();
+        palette.push_back(color);
+        if(i % 3 != 0)
+            mappedColors[color] = random();
+    }
+    // Transparent black has no special meaning for the kernels,
+    // it must be mapped like any other color.
+    palette.push_back(0x00000000);
+    mappedColors[0x00000000] = 0x11223344;
+
+    std::vector<sf::Uint8> pixels;
+    while(pixels.size() < 4 * 4099) {
+        sf::Uint32 color = palette[random() % palette.size()];
+        int length = (random() % 4 == 0) ? 1 : 1 + random() % 40;
+        for(int j = 0; j < length; j++) {
+            for(int k = 3; k >= 0; k--)
+                pixels.push_back((color >> (8*k)) & 0xFF);
+        }
+    }
+
+    std::vector<std::pair<std::string, MapPixelsKernel>> kernels;
+#ifdef IMAGE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        kernels.push_back({"avx2", MapPixelsAVX2});
+    if(__builtin_cpu_supports("ssse3"))
+        kernels.push_back({"ssse3", MapPixelsSSSE3});
+#endif
+
+    for(std::size_t count : { (std::size_t) 0, (std::size_t) 1, (std::size_t) 7, (std::size_t) 8, (std::size_t) 9, (std::size_t) 4099 }) {
+        std::vector<sf::Uint8> expected(count * 4);
+        MapPixelsScalar(pixels.data(), expected.data(), count, mappedColors);
+
+        for(const auto& [name, kernel] : kernels) {
+            std::vector<sf::Uint8> got(count * 4);
+            kernel(pixels.data(), got.data(), count, mappedColors);
+            if(expected != got) {
+                std::size_t index = std::mismatch(expected.begin(), expected.end(), got.begin()).first - expected.begin();
+                throw std::runtime_error(fmt::format("Failed tests for Image::MapPixels {} kernel with {} pixels at pixel {}", name, count, index / 4));
+            }
+        }
+    }
+
+    // Mapping an area must give the same pixels as the area of the whole mapped image.
+    sf::Image image;
+    image.create(64, pixels.size() / 4 / 64, pixels.data());
+    const auto& MapFunc = [&](auto& colors) { colors.insert(mappedColors.begin(), mappedColors.end()); };
+    sf::Image mappedImage = MapPixels(image, MapFunc);
+
+    for(const sf::IntRect& area : { sf::IntRect(0, 0, 64, 64), sf::IntRect(0, 10, 64, 3), sf::IntRect(3, 5, 17, 20), sf::IntRect(63, 63, 1, 1) }) {
+        sf::Image mappedArea = MapPixels(image, area, MapFunc);
+        for(int y = 0; y < area.height; y++) {
+            for(int x = 0; x < area.width; x++) {
+                if(mappedArea.getPixel(x, y) != mappedImage.getPixel(area.left + x, area.top + y))
+                    throw std::runtime_error(fmt::format("Failed tests for Image::MapPixels with area ({}, {}, {}, {}) at pixel ({}, {})", area.left, area.top, area.width, area.height, x, y));
+            }
+        }
+    }
+
+    // The image has less than 256 colors, so it must be restored exactly from its indices.
+    std::vector<sf::Uint8> indices;
+    std::vector<sf::Uint32> indexedPalette;
+    if(!ToIndexed(image, indices, indexedPalette) || indexedPalette.size() > palette.size())
+        throw std::runtime_error(fmt::format("Failed tests for Image::ToIndexed with {} colors (got {})", palette.size(), indexedPalette.size()));
+
+    sf::Image restoredImage = FromIndexed(image.getSize(), indices, indexedPalette);
+    if(!std::equal(image.getPixelsPtr(), image.getPixelsPtr() + image.getSize().x * image.getSize().y * 4, restoredImage.getPixelsPtr()))
+        throw std::runtime_error("Failed tests for Image::FromIndexed");
+
+    // Each pixel of an area of the ids image must get the color of its id, or of id 0.
+    std::vector<sf::Uint8> idsPixels(64 * 64 * 4, 0);
+    for(uint i = 0; i < 64 * 64; i++) {
+        idsPixels[i*4 + 2] = i % 5;
+        idsPixels[i*4 + 3] = 255;
+    }
+    sf::Image idsImage;
+    idsImage.create(64, 64, idsPixels.data());
+    const std::vector<sf::Uint32> idsPalette = { 0x000000FF, 0xFF0000FF, 0x00FF00FF, 0x0000FFFF };
+
+    const sf::IntRect idsArea = sf::IntRect(3, 5, 17, 20);
+    sf::Image mappedIds = MapIds(idsImage, idsArea, idsPalette);
+    for(int y = 0; y < idsArea.height; y++) {
+        for(int x = 0; x < idsArea.width; x++) {
+            const uint id = ((idsArea.top + y) * 64 + idsArea.left + x) % 5;
+            if(mappedIds.getPixel(x, y).toInteger() != idsPalette[id < idsPalette.size() ? id : 0])
+                throw std::runtime_error(fmt::format("Failed tests for Image::MapIds at pixel ({}, {})", x, y));
+        }
+    }
+}
@@ -2,4 +2,31 @@
 
 namespace Image {
     sf::Image MapPixels(const sf::Image& originalImage, std::function<void(std::unordered_map<sf::Uint32, sf::Uint32>&)> mapFunc);
+
+    // Same as above but only map the pixels of an area of the original image,
+    // the generated image has the size of the area.
+    sf::Image MapPixels(const sf::Image& originalImage, const sf::IntRect& area, std::function<void(std::unordered_map<sf::Uint32, sf::Uint32>&)> mapFunc);
+
+    // Generate the image of an area of an ids image (ids stored in the RGB bytes,
+    // see Mod::GetProvinceIdsImage) where each pixel gets the color of its id in
+    // the palette. Ids outside of the palette get the color of id 0.
+    sf::Image MapIds(const sf::Image& idsImage, const sf::IntRect& area, const std::vector<sf::Uint32>& palette);
+
+    // Get the pixel of a color region that is the farthest from its borders
+    // (pole of inaccessibility), searching only in the given bounding box.
+    // Returns fallback if no pixel of the region could be found.
+    sf::Vector2i GetInteriorPoint(const sf::Image& image, sf::Uint32 color, const sf::IntRect& box, sf::Vector2i fallback);
+
+    // Keep a single channel (red) of the pixels of a grayscale image, and
+    // expand it back to RGBA pixels.
+    std::vector<sf::Uint8> ToGrayscale(const sf::Image& image);
+    sf::Image FromGrayscale(sf::Vector2u size, const std::vector<sf::Uint8>& pixels);
+
+    // Replace the pixels of an image by their index in a palette of at most 256 colors,
+    // and expand them back to RGBA pixels. Returns false if there are more colors,
+    // in which case the remaining ones are replaced by the first color of the palette.
+    bool ToIndexed(const sf::Image& image, std::vector<sf::Uint8>& indices, std::vector<sf::Uint32>& palette);
+    sf::Image FromIndexed(sf::Vector2u size, const std::vector<sf::Uint8>& indices, const std::vector<sf::Uint32>& palette);
+
+    void Tests();
 }
\ No newline at end of file
@@ -6,4 +6,14 @@ int Math::RandomInt(int min, int max) {
 
 float Math::RandomFloat(float min, float max) {
     return min + (((float) rand()) / (float) RAND_MAX) * (max-min);
+}
+
+sf::IntRect Math::UnionRect(const sf::IntRect& a, const sf::IntRect& b) {
+    if(a.width <= 0 || a.height <= 0) return b;
+    if(b.width <= 0 || b.height <= 0) return a;
+    int left = std::min(a.left, b.left);
+    int top = std::min(a.top, b.top);
+    int right = std::max(a.left + a.width, b.left + b.width);
+    int bottom = std::max(a.top + a.height, b.top + b.height);
+    return sf::IntRect(left, top, right - left, bottom - top);
 }
\ No newline at end of file
@@ -3,4 +3,7 @@
 namespace Math {
     int RandomInt(int min, int max);
     float RandomFloat(float min, float max);
+
+    // Smallest rectangle containing both rectangles, ignoring empty ones.
+    sf::IntRect UnionRect(const sf::IntRect& a, const sf::IntRect& b);
 }
\ No newline at end of file
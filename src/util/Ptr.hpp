@@ -24,4 +24,10 @@ inline bool IsInstance(const SharedPtr<Base>& ptr) {
 template <typename Derived, typename Base>
 inline SharedPtr<Derived> CastSharedPtr(const SharedPtr<Base>& ptr) {
 	return std::dynamic_pointer_cast<Derived>(ptr);
-}
\ No newline at end of file
+}
+
+// Cast without checking the type at runtime, when it is already known (e.g. from Title::GetType).
+template <typename Derived, typename Base>
+inline SharedPtr<Derived> StaticCastSharedPtr(const SharedPtr<Base>& ptr) {
+	return std::static_pointer_cast<Derived>(ptr);
+}
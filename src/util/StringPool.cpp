@@ -0,0 +1,25 @@
+#include "StringPool.hpp"
+
+StringPool::StringPool(const std::string& defaultString) {
+    this->Intern(defaultString);
+}
+
+uint StringPool::Intern(const std::string& str) {
+    const auto& [it, inserted] = m_Ids.try_emplace(str, m_Strings.size());
+    if(inserted)
+        m_Strings.push_back(str);
+    return it->second;
+}
+
+int StringPool::Find(const std::string& str) const {
+    const auto& it = m_Ids.find(str);
+    return (it == m_Ids.end()) ? -1 : (int) it->second;
+}
+
+const std::string& StringPool::Get(uint id) const {
+    return (id < m_Strings.size()) ? m_Strings[id] : m_Strings[0];
+}
+
+uint StringPool::GetCount() const {
+    return m_Strings.size();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Assign small integer ids to strings, so that objects store and compare
+// an id instead of their own copy of a string shared by many of them.
+// Id 0 is always assigned to the default string (empty by default).
+class StringPool {
+public:
+    StringPool(const std::string& defaultString = "");
+
+    // Get the id of a string, assigning the next id if it isn't in the pool yet.
+    uint Intern(const std::string& str);
+
+    // Get the id of a string, or -1 if it isn't in the pool.
+    int Find(const std::string& str) const;
+
+    const std::string& Get(uint id) const;
+    uint GetCount() const;
+
+private:
+    std::vector<std::string> m_Strings;
+    std::unordered_map<std::string, uint> m_Ids;
+};
@@ -0,0 +1,247 @@
+#include "ThreadPool.hpp"
+
+// Index of the queue of the current thread if it is a worker of s_WorkerPool.
+static thread_local ThreadPool* s_WorkerPool = nullptr;
+static thread_local uint s_WorkerIndex = 0;
+
+// Number of pixels per chunk: 64KB of RGBA pixels to stay in the L2 cache.
+static const uint PIXELS_PER_CHUNK = 16384;
+
+///////////////////////////////
+//           Task            //
+///////////////////////////////
+
+Task::Task(ThreadPool* pool, std::function<void()> func)
+: m_Pool(pool), m_Function(func), m_Done(false)
+{}
+
+bool Task::IsDone() const {
+    return m_Done;
+}
+
+void Task::Wait() {
+    m_Pool->WaitFor(*this);
+}
+
+SharedPtr<Task> Task::Then(std::function<void()> func) {
+    SharedPtr<Task> task = MakeShared<Task>(m_Pool, func);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(!m_Done) {
+            m_Continuations.push_back(task);
+            return task;
+        }
+    }
+    m_Pool->Push(task);
+    return task;
+}
+
+void Task::Run() {
+    m_Function();
+    m_Function = nullptr;
+
+    std::vector<SharedPtr<Task>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Done = true;
+        continuations.swap(m_Continuations);
+    }
+    for(auto& continuation : continuations)
+        m_Pool->Push(continuation);
+
+    m_Pool->NotifyTaskDone();
+}
+
+///////////////////////////////
+//        ThreadPool         //
+///////////////////////////////
+
+ThreadPool::ThreadPool(uint threadsCount)
+: m_PendingTasks(0), m_Waiters(0), m_Stopping(false)
+{
+    for(uint i = 0; i <= threadsCount; i++)
+        m_Queues.push_back(MakeUnique<Queue>());
+
+    for(uint i = 0; i < threadsCount; i++)
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Stopping = true;
+    }
+    m_SleepCondition.notify_all();
+
+    for(auto& thread : m_Threads)
+        thread.join();
+}
+
+uint ThreadPool::GetThreadsCount() const {
+    return m_Threads.size();
+}
+
+SharedPtr<Task> ThreadPool::Submit(std::function<void()> func) {
+    SharedPtr<Task> task = MakeShared<Task>(this, func);
+    this->Push(task);
+    return task;
+}
+
+void ThreadPool::ParallelFor(uint count, uint grainSize, const std::function<void(uint begin, uint end)>& func) {
+    grainSize = std::max(1u, grainSize);
+    const uint chunksCount = (count + grainSize - 1) / grainSize;
+
+    if(chunksCount == 0)
+        return;
+    if(chunksCount == 1) {
+        func(0, count);
+        return;
+    }
+
+    // Chunks are handed out dynamically through a shared counter to every thread
+    // taking part in the loop: the caller and up to one helper task per worker.
+    // Helpers that start after all chunks have been taken return immediately.
+    std::atomic<uint> nextChunk = 0;
+    const auto& ProcessChunks = [&]() {
+        uint chunk;
+        while((chunk = nextChunk++) < chunksCount) {
+            uint begin = chunk * grainSize;
+            func(begin, std::min(count, begin + grainSize));
+        }
+    };
+
+    std::vector<SharedPtr<Task>> helpers;
+    const uint helpersCount = std::min<uint>(this->GetThreadsCount(), chunksCount - 1);
+    for(uint i = 0; i < helpersCount; i++)
+        helpers.push_back(this->Submit(ProcessChunks));
+
+    ProcessChunks();
+
+    for(const auto& helper : helpers)
+        helper->Wait();
+}
+
+void ThreadPool::ParallelForPixels(uint totalPixels, const std::function<void(uint begin, uint end)>& func) {
+    this->ParallelFor(totalPixels, PIXELS_PER_CHUNK, func);
+}
+
+UniquePtr<ThreadPool>& ThreadPool::Get() {
+    // Keep one core for the thread submitting the tasks, which
+    // works on them too while waiting for their completion.
+    // hardware_concurrency() returns 0 if it can't be determined.
+    static UniquePtr<ThreadPool> instance = MakeUnique<ThreadPool>(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return instance;
+}
+
+void ThreadPool::Push(SharedPtr<Task> task) {
+    // Workers push in their own queue (depth-first for nested tasks),
+    // other threads in the shared queue.
+    uint index = (s_WorkerPool == this) ? s_WorkerIndex : m_Queues.size() - 1;
+    {
+        std::lock_guard<std::mutex> lock(m_Queues[index]->mutex);
+        m_Queues[index]->tasks.push_back(task);
+    }
+    m_PendingTasks++;
+
+    // Lock to make sure a thread about to sleep doesn't miss the notification.
+    { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+    m_SleepCondition.notify_one();
+}
+
+SharedPtr<Task> ThreadPool::Pop() {
+    // Take the most recent task of our own queue, otherwise steal
+    // the oldest task of the shared queue or of another worker.
+    const uint queuesCount = m_Queues.size();
+    const bool isWorker = (s_WorkerPool == this);
+    const uint start = isWorker ? s_WorkerIndex : queuesCount - 1;
+
+    for(uint i = 0; i < queuesCount; i++) {
+        Queue& queue = *m_Queues[(start + i) % queuesCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if(queue.tasks.empty())
+            continue;
+
+        SharedPtr<Task> task;
+        if(i == 0 && isWorker) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        m_PendingTasks--;
+        return task;
+    }
+    return nullptr;
+}
+
+SharedPtr<Task> ThreadPool::Take(const Task& task) {
+    // Remove the task from the queue it was pushed in, if no thread started it yet.
+    for(auto& queue : m_Queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        for(auto it = queue->tasks.begin(); it != queue->tasks.end(); it++) {
+            if(it->get() != &task)
+                continue;
+            SharedPtr<Task> taken = *it;
+            queue->tasks.erase(it);
+            m_PendingTasks--;
+            return taken;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint index) {
+    s_WorkerPool = this;
+    s_WorkerIndex = index;
+
+    while(true) {
+        SharedPtr<Task> task = this->Pop();
+        if(task != nullptr) {
+            task->Run();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_SleepCondition.wait(lock, [&]() { return m_Stopping || m_PendingTasks > 0; });
+        if(m_Stopping)
+            return;
+    }
+}
+
+void ThreadPool::WaitFor(const Task& task) {
+    // Workers help with any task, so that nested waits can't starve the pool.
+    // Other threads (the main thread) only run the awaited task if it didn't
+    // start yet: popping an arbitrary one could stall them on a long background job.
+    const bool isWorker = (s_WorkerPool == this);
+
+    while(!task.IsDone()) {
+        SharedPtr<Task> other = isWorker ? this->Pop() : this->Take(task);
+        if(other != nullptr) {
+            other->Run();
+            continue;
+        }
+
+        // Nothing left to help with, sleep until a task is
+        // done or a new one is pushed.
+        // Other threads have their own condition, so that they can't
+        // take the notification of a pushed task from an idle worker.
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Waiters++;
+        if(isWorker)
+            m_SleepCondition.wait(lock, [&]() { return task.IsDone() || m_PendingTasks > 0; });
+        else
+            m_WaitCondition.wait(lock, [&]() { return task.IsDone(); });
+        m_Waiters--;
+    }
+}
+
+void ThreadPool::NotifyTaskDone() {
+    if(m_Waiters == 0)
+        return;
+    { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+    m_SleepCondition.notify_all();
+    m_WaitCondition.notify_all();
+}
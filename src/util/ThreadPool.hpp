@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+class ThreadPool;
+
+class Task : public std::enable_shared_from_this<Task> {
+public:
+    Task(ThreadPool* pool, std::function<void()> func);
+
+    bool IsDone() const;
+
+    // Block until the task is done. Workers execute other tasks of the pool
+    // in the meantime, other threads only run this task if it didn't start yet.
+    void Wait();
+
+    // Schedule a task to be submitted once this one is done.
+    SharedPtr<Task> Then(std::function<void()> func);
+
+private:
+    friend ThreadPool;
+
+    void Run();
+
+    ThreadPool* m_Pool;
+    std::function<void()> m_Function;
+    std::atomic<bool> m_Done;
+    std::mutex m_Mutex;
+    std::vector<SharedPtr<Task>> m_Continuations;
+};
+
+class ThreadPool {
+public:
+    ThreadPool(uint threadsCount);
+    ~ThreadPool();
+
+    uint GetThreadsCount() const;
+
+    SharedPtr<Task> Submit(std::function<void()> func);
+
+    // Call func(begin, end) over the range [0, count) split in chunks of grainSize
+    // and block until the whole range is processed. The calling thread works on the
+    // chunks of this loop too, so it is safe to nest parallel loops inside tasks.
+    void ParallelFor(uint count, uint grainSize, const std::function<void(uint begin, uint end)>& func);
+
+    // Same as ParallelFor over the pixels of an image, split in chunks fitting
+    // in the cache. The chunks are linear ranges of pixel indices (in row-major
+    // order, possibly spanning several rows), not 2D tiles.
+    void ParallelForPixels(uint totalPixels, const std::function<void(uint begin, uint end)>& func);
+
+    static UniquePtr<ThreadPool>& Get();
+
+private:
+    friend Task;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<SharedPtr<Task>> tasks;
+    };
+
+    void Push(SharedPtr<Task> task);
+    SharedPtr<Task> Pop();
+    SharedPtr<Task> Take(const Task& task);
+    void WorkerLoop(uint index);
+    void WaitFor(const Task& task);
+    void NotifyTaskDone();
+
+    // One queue per worker and a last one for tasks
+    // submitted from threads outside of the pool.
+    std::vector<UniquePtr<Queue>> m_Queues;
+    std::vector<std::thread> m_Threads;
+
+    std::atomic<int> m_PendingTasks;
+    std::atomic<int> m_Waiters;
+    std::mutex m_SleepMutex;
+    std::condition_variable m_SleepCondition;
+    std::condition_variable m_WaitCondition;
+    bool m_Stopping;
+};
@@ -0,0 +1,144 @@
+#include "TiledTexture.hpp"
+
+TiledTexture::TiledTexture()
+: TiledTexture(GetTileSize(), GetTileSize())
+{}
+
+TiledTexture::TiledTexture(uint tileWidth, uint tileHeight)
+: m_TileSize(tileWidth, tileHeight), m_Size(0, 0), m_TilesCount(0, 0), m_PendingTilesCount(0)
+{}
+
+void TiledTexture::InitTiles(sf::Vector2u size) {
+    m_Size = size;
+    m_TilesCount = sf::Vector2u(
+        (size.x + m_TileSize.x - 1) / m_TileSize.x,
+        (size.y + m_TileSize.y - 1) / m_TileSize.y
+    );
+    m_Tiles = std::vector<Tile>(m_TilesCount.x * m_TilesCount.y);
+
+    for(uint y = 0; y < m_TilesCount.y; y++) {
+        for(uint x = 0; x < m_TilesCount.x; x++) {
+            Tile& tile = m_Tiles[y * m_TilesCount.x + x];
+            tile.bounds.left = x * m_TileSize.x;
+            tile.bounds.top = y * m_TileSize.y;
+            tile.bounds.width = std::min(m_TileSize.x, size.x - tile.bounds.left);
+            tile.bounds.height = std::min(m_TileSize.y, size.y - tile.bounds.top);
+            tile.uploaded = false;
+        }
+    }
+}
+
+void TiledTexture::Create(sf::Vector2u size) {
+    this->InitTiles(size);
+    m_Image = sf::Image();
+    m_PendingTilesCount = 0;
+
+    for(Tile& tile : m_Tiles) {
+        tile.texture.create(tile.bounds.width, tile.bounds.height);
+        tile.uploaded = true;
+    }
+}
+
+void TiledTexture::LoadFromImage(sf::Image image) {
+    this->InitTiles(image.getSize());
+    m_Image = std::move(image);
+    m_PendingTilesCount = m_Tiles.size();
+}
+
+void TiledTexture::Update(const sf::Uint8* pixels, uint width, uint height, uint x, uint y) {
+    sf::IntRect area(x, y, width, height);
+    std::vector<sf::Uint8> tilePixels;
+
+    for(Tile& tile : m_Tiles) {
+        sf::IntRect intersection;
+        if(!tile.uploaded || !tile.bounds.intersects(area, intersection))
+            continue;
+
+        const uint rowSize = intersection.width * 4;
+        tilePixels.resize(rowSize * intersection.height);
+        for(int row = 0; row < intersection.height; row++) {
+            const sf::Uint8* source = pixels + ((intersection.top - y + row) * width + (intersection.left - x)) * 4;
+            std::copy_n(source, rowSize, &tilePixels[row * rowSize]);
+        }
+        tile.texture.update(
+            tilePixels.data(), intersection.width, intersection.height,
+            intersection.left - tile.bounds.left, intersection.top - tile.bounds.top
+        );
+    }
+
+    // Tiles that are not uploaded yet are read from the image.
+    if(m_PendingTilesCount > 0) {
+        sf::Image image;
+        image.create(width, height, pixels);
+        m_Image.copy(image, x, y);
+    }
+}
+
+void TiledTexture::Update(const sf::Image& image, uint x, uint y) {
+    this->Update(image.getPixelsPtr(), image.getSize().x, image.getSize().y, x, y);
+}
+
+sf::Vector2u TiledTexture::GetSize() const {
+    return m_Size;
+}
+
+uint TiledTexture::GetTilesCount() const {
+    return m_Tiles.size();
+}
+
+sf::IntRect TiledTexture::GetTileBounds(uint index) const {
+    return m_Tiles[index].bounds;
+}
+
+uint64_t TiledTexture::GetMemoryUsage() const {
+    uint64_t usage = 0;
+    for(const Tile& tile : m_Tiles) {
+        if(tile.uploaded)
+            usage += (uint64_t) tile.bounds.width * tile.bounds.height * 4;
+    }
+    if(m_PendingTilesCount > 0)
+        usage += (uint64_t) m_Image.getSize().x * m_Image.getSize().y * 4;
+    return usage;
+}
+
+std::vector<uint> TiledTexture::GetTiles(const sf::FloatRect& area) const {
+    std::vector<uint> tiles;
+    if(m_Tiles.empty() || area.width <= 0 || area.height <= 0)
+        return tiles;
+
+    // The area is outside of the texture.
+    if(area.left >= m_Size.x || area.top >= m_Size.y || area.left + area.width <= 0 || area.top + area.height <= 0)
+        return tiles;
+
+    // Positions are clamped to the tiles on the edges of the texture.
+    const auto& TileCoordinate = [](float position, uint tileSize, uint tilesCount) {
+        return (uint) std::clamp(position / tileSize, 0.f, (float) tilesCount - 1);
+    };
+    uint left = TileCoordinate(area.left, m_TileSize.x, m_TilesCount.x);
+    uint top = TileCoordinate(area.top, m_TileSize.y, m_TilesCount.y);
+    uint right = TileCoordinate(area.left + area.width, m_TileSize.x, m_TilesCount.x);
+    uint bottom = TileCoordinate(area.top + area.height, m_TileSize.y, m_TilesCount.y);
+
+    for(uint y = top; y <= bottom; y++)
+        for(uint x = left; x <= right; x++)
+            tiles.push_back(y * m_TilesCount.x + x);
+    return tiles;
+}
+
+const sf::Texture& TiledTexture::GetTile(uint index) {
+    Tile& tile = m_Tiles[index];
+    if(!tile.uploaded) {
+        tile.texture.loadFromImage(m_Image, tile.bounds);
+        tile.uploaded = true;
+
+        // Release the image once all tiles have been uploaded.
+        if(--m_PendingTilesCount == 0)
+            m_Image = sf::Image();
+    }
+    return tile.texture;
+}
+
+uint TiledTexture::GetTileSize() {
+    static const uint size = std::min(4096u, sf::Texture::getMaximumSize());
+    return size;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// Texture split in tiles of a fixed size, to display images larger than the
+// maximum size of textures supported by the GPU (sf::Texture::getMaximumSize()).
+// Tiles loaded from an image are only uploaded the first time they are
+// requested, the image is kept until every tile has been uploaded.
+class TiledTexture {
+public:
+    TiledTexture();
+    TiledTexture(uint tileWidth, uint tileHeight);
+
+    // Allocate every tile of the texture, with undefined pixels.
+    void Create(sf::Vector2u size);
+    void LoadFromImage(sf::Image image);
+
+    // Update the pixels of an area of the texture, only the
+    // tiles intersecting the area are uploaded again.
+    void Update(const sf::Uint8* pixels, uint width, uint height, uint x, uint y);
+    void Update(const sf::Image& image, uint x, uint y);
+
+    sf::Vector2u GetSize() const;
+    uint GetTilesCount() const;
+    sf::IntRect GetTileBounds(uint index) const;
+
+    // Bytes used by the uploaded tiles and by the image
+    // kept for the tiles that are not uploaded yet.
+    uint64_t GetMemoryUsage() const;
+
+    // Indices of the tiles intersecting an area of the texture.
+    std::vector<uint> GetTiles(const sf::FloatRect& area) const;
+
+    // Get the texture of a tile, uploading it first if needed.
+    const sf::Texture& GetTile(uint index);
+
+    // Size of the tiles of the map textures: the largest size supported by
+    // every driver, small enough to upload a single tile without stalling.
+    static uint GetTileSize();
+
+private:
+    struct Tile {
+        sf::IntRect bounds;
+        sf::Texture texture;
+        bool uploaded;
+    };
+
+    sf::Vector2u m_TileSize;
+    sf::Vector2u m_Size;
+    sf::Vector2u m_TilesCount;
+    std::vector<Tile> m_Tiles;
+
+    // Pixels of the tiles that are not uploaded yet.
+    sf::Image m_Image;
+    uint m_PendingTilesCount;
+
+    void InitTiles(sf::Vector2u size);
+};